@@ -56,6 +56,7 @@
 
 /* UART CONF1 bits */
 #define UART_RX_TOUT_EN   (1 << 31)
+#define UART_TXFIFO_EMPTY_THRHD_SHIFT  8   /* bits 8-14 */
 
 /* UART STATUS field masks */
 #define UART_TXFIFO_CNT_MASK   0x000000FF
@@ -104,6 +105,20 @@
 /* GPIO pin configuration registers (one per pin, 0-15) */
 #define GPIO_PIN(n)       REG32(GPIO_BASE + 0x28 + (n) * 4)
 
+/* ======== SPI0 (flash controller) registers (0x60000200) ======== */
+#define SPI0_BASE         0x60000200
+
+#define SPI0_CMD          REG32(SPI0_BASE + 0x00)  /* Write a command bit; clears when done */
+#define SPI0_ADDR         REG32(SPI0_BASE + 0x04)  /* 24-bit flash address */
+#define SPI0_RD_STATUS    REG32(SPI0_BASE + 0x10)  /* Flash status register */
+
+#define SPI_CMD_WREN      (1 << 30)   /* Write enable */
+#define SPI_CMD_RDSR      (1 << 27)   /* Read status register */
+#define SPI_CMD_SE        (1 << 24)   /* 4KB sector erase */
+
+#define SPI_SR_WIP        (1 << 0)    /* Write/erase in progress */
+#define SPI_SR_WEL        (1 << 1)    /* Write enable latch */
+
 /* ======== WDT (Watchdog Timer) registers (0x60000900) ======== */
 #define WDT_BASE          0x60000900
 
@@ -35,10 +35,17 @@
 
 /* Filesystem (OsitoFS) — flat FS on SPI flash */
 #define FS_SECTOR_SIZE  4096
-#define FS_MAX_FILES    128          /* max files (fits in 1 sector: 128*32=4096) */
+#define FS_MAX_FILES    4096         /* max entries (v2: 64 dir sectors x 64) */
+#define FS_DIR_SECTORS_MAX 64        /* directory grows one sector at a time */
+#define FS_HASH_BUCKETS 8192         /* on-flash name index (4 sectors, 2B each) */
+#define FS_FRAG_SECTORS_MAX 256      /* shared small-file sectors tracked in RAM */
 #define FS_NAME_LEN     24           /* max filename length including null */
+#define FS_PATH_LEN     (2 * FS_NAME_LEN)  /* "dir/name" including null */
 #define FS_FLASH_BASE   0x40000      /* 256KB offset — firmware is below this */
 #define FS_FLASH_END    0x400000     /* 4MB flash boundary */
+#define FS_CACHE_BYTES  0            /* read cache heap budget (0 = off; 4224 = 16 x 256B) */
+#define FS_CACHE_PAGE   256          /* read cache page size (256..4096) */
+#define FLASHIO_QUEUE_LEN 8          /* pending flash erase/program requests */
 
 /* UART configuration */
 #define UART_BAUD       115200
@@ -47,6 +54,15 @@
 /* Context frame size: 20 registers * 4 bytes = 80 bytes */
 #define CONTEXT_FRAME_SIZE 80
 
+/* Optional code, 0 = left out of the image (IRAM is 32 KB for all of
+ * it). Override from make: make BENCH=1 FBREC=1 */
+#ifndef OSITO_BENCH
+#define OSITO_BENCH     0            /* self-tests, benchmarks, fs zstat */
+#endif
+#ifndef OSITO_FBREC
+#define OSITO_FBREC     0            /* rec: framebuffer recorder/player */
+#endif
+
 /* DRAM boundaries */
 #define DRAM_START      0x3FFE8000
 #define DRAM_END        0x3FFFBFFF
@@ -4,6 +4,16 @@
 #ifndef OSITO_TYPES_H
 #define OSITO_TYPES_H
 
+#ifdef OSITO_HOST
+/*
+ * Host build (tools/ositofs): take the fixed-width types from the host
+ * libc so kernel sources can be linked into native tools unchanged.
+ */
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/types.h>
+#else
+
 typedef unsigned char      uint8_t;
 typedef signed char        int8_t;
 typedef unsigned short     uint16_t;
@@ -16,6 +26,7 @@ typedef signed long long   int64_t;
 typedef uint32_t size_t;
 typedef int32_t  ssize_t;
 typedef int32_t  ptrdiff_t;
+typedef uint32_t uintptr_t;
 
 #ifndef __cplusplus
 typedef _Bool bool;
@@ -31,6 +42,8 @@ typedef _Bool bool;
 #endif
 #endif
 
+#endif /* OSITO_HOST */
+
 #define INLINE       static inline __attribute__((always_inline))
 #define NOINLINE     __attribute__((noinline))
 #define NORETURN     __attribute__((noreturn))
@@ -40,6 +53,27 @@ typedef _Bool bool;
 #define USED         __attribute__((used))
 #define SECTION(s)   __attribute__((section(s)))
 
+#ifdef OSITO_HOST
+
+/* Host build: single-threaded, no special registers */
+#define MEMORY_BARRIER()  __asm__ volatile("" ::: "memory")
+#define ISR_BARRIER()     __asm__ volatile("" ::: "memory")
+
+INLINE uint32_t irq_save(void) { return 0; }
+INLINE void irq_restore(uint32_t ps) { (void)ps; }
+INLINE int irq_enabled(void) { return 0; }
+INLINE uint32_t get_ccount(void) { return 0; }
+
+/* Code placement is target-only (the Makefile defines these there) */
+#ifndef ICACHE_FLASH_ATTR
+#define ICACHE_FLASH_ATTR
+#endif
+#ifndef IRAM_ATTR
+#define IRAM_ATTR
+#endif
+
+#else
+
 /* Barrier macros */
 #define MEMORY_BARRIER()  __asm__ volatile("memw" ::: "memory")
 #define ISR_BARRIER()     __asm__ volatile("isync" ::: "memory")
@@ -77,4 +111,19 @@ INLINE void irq_restore(uint32_t ps) {
     __asm__ volatile("wsr %0, ps; isync" :: "a"(ps));
 }
 
+/* Are interrupts taken here? PS.INTLEVEL 0 and PS.EXCM clear: task
+ * context, not an ISR or an irq_save() section */
+INLINE int irq_enabled(void) {
+    return (RSR(230) & 0x1F) == 0;
+}
+
+/* CPU cycle counter (CPU_FREQ_HZ), wraps every ~53s at 80MHz */
+INLINE uint32_t get_ccount(void) {
+    uint32_t c;
+    __asm__ volatile("rsr %0, ccount" : "=a"(c));
+    return c;
+}
+
+#endif /* OSITO_HOST */
+
 #endif /* OSITO_TYPES_H */
@@ -1,7 +1,8 @@
 /*
  * OsitoK - UART0 driver
  *
- * TX: polled (write to FIFO, wait if full)
+ * TX: polled (write to FIFO, wait if full), or one background buffer
+ *     refilled from the TX FIFO empty interrupt (uart_write_async)
  * RX: interrupt-driven with 64-byte ring buffer
  *
  * The UART interrupt (INUM 5) is dispatched by os_exception_handler()
@@ -19,13 +20,37 @@ static volatile uint8_t rx_buf[UART_RX_BUF_SIZE];
 static volatile uint8_t rx_head = 0;  /* Write index (ISR writes here) */
 static volatile uint8_t rx_tail = 0;  /* Read index (user reads from here) */
 
-/* ====== UART RX interrupt handler ====== */
+/* ====== Background TX ====== */
+
+/* Bytes the line sends per scheduler tick (10 bits each) */
+#define UART_BYTES_PER_TICK (UART_BAUD / 10 / TICK_HZ)
+
+static const uint8_t *volatile tx_ptr;
+static volatile uint16_t tx_left = 0;
+
+/* Top up the TX FIFO from the background buffer; stop the interrupt
+ * once it is all queued. Called from the ISR or with IRQs off. */
+static void IRAM_ATTR tx_fill(void)
+{
+    REG32(0x60000914) = 0x73;
+
+    while (tx_left &&
+           ((UART0_STATUS >> UART_TXFIFO_CNT_SHIFT) & UART_TXFIFO_CNT_MASK) < 126) {
+        UART0_FIFO = (uint32_t)*tx_ptr++;
+        tx_left--;
+    }
+    if (tx_left == 0)
+        UART0_INT_ENA &= ~UART_TXFIFO_EMPTY_INT;
+}
+
+/* ====== UART interrupt handler ====== */
 
 /*
  * uart_isr_handler - UART0 interrupt handler
  *
  * Called from os_exception_handler() when INUM_UART is pending.
- * Reads all available bytes from the FIFO into the ring buffer.
+ * Reads all available bytes from the FIFO into the ring buffer, and
+ * refills the TX FIFO while a background write is in progress.
  *
  * Runs in exception context (IRAM required).
  */
@@ -50,6 +75,10 @@ void IRAM_ATTR uart_isr_handler(void)
         }
     }
 
+    /* TX FIFO below threshold */
+    if (status & UART_TXFIFO_EMPTY_INT)
+        tx_fill();
+
     /* Clear all UART interrupts */
     UART0_INT_CLR = 0xFFFFFFFF;
 }
@@ -85,14 +114,17 @@ void uart_init(void)
 
     /* Configure CONF1:
      *   - RX FIFO full threshold = 1 byte (bits 0-6)
+     *   - TX FIFO empty threshold = 32 bytes (bits 8-14)
      *   - RX timeout enable (bit 31)
      *   - RX timeout threshold = 10 (bits 24-30)
      */
     UART0_CONF1 = (1 << 0)          /* RXFIFO full threshold = 1 */
+                | (32 << UART_TXFIFO_EMPTY_THRHD_SHIFT)
                 | UART_RX_TOUT_EN    /* Enable RX timeout */
                 | (10 << 24);        /* Timeout threshold = 10 bit-times */
 
-    /* Enable RX interrupts at the UART peripheral level */
+    /* Enable RX interrupts at the UART peripheral level.
+     * The TX FIFO empty interrupt is only on during uart_write_async. */
     UART0_INT_ENA = UART_RXFIFO_FULL_INT | UART_RXFIFO_TOUT_INT;
 
     /* INUM_UART is enabled in INTENABLE by timer_init() */
@@ -102,6 +134,10 @@ void uart_init(void)
 
 void uart_putc(char c)
 {
+    /* Never split a background write */
+    if (tx_left)
+        uart_tx_wait();
+
     /* Feed HW WDT to prevent reset during long output */
     REG32(0x60000914) = 0x73;
 
@@ -174,6 +210,9 @@ bool uart_rx_available(void)
 
 void uart_write_raw(const uint8_t *buf, uint16_t len)
 {
+    if (tx_left)
+        uart_tx_wait();
+
     for (uint16_t i = 0; i < len; i++) {
         /* Feed HW WDT periodically */
         if ((i & 0x7F) == 0)
@@ -187,4 +226,43 @@ void uart_write_raw(const uint8_t *buf, uint16_t len)
     }
 }
 
+void uart_write_async(const uint8_t *buf, uint16_t len)
+{
+    uart_tx_wait();
+
+    uint32_t ps = irq_save();
+    tx_ptr = buf;
+    tx_left = len;
+    tx_fill();
+    if (tx_left)
+        UART0_INT_ENA |= UART_TXFIFO_EMPTY_INT;
+    irq_restore(ps);
+}
+
+bool uart_tx_busy(void)
+{
+    return tx_left != 0;
+}
+
+void uart_tx_wait(void)
+{
+    /* The TX interrupt is draining the buffer: let other tasks run.
+     * Sleep while more than a tick's worth is left, then yield, so the
+     * caller resumes soon after the last byte is queued. */
+    if (irq_enabled() && (UART0_INT_ENA & UART_TXFIFO_EMPTY_INT)) {
+        while (tx_left > UART_BYTES_PER_TICK)
+            task_delay_ticks(1);
+        while (tx_left)
+            task_yield();
+        return;
+    }
+
+    /* IRQs masked (ISR, early boot, irq_save): fill the FIFO by hand */
+    while (tx_left) {
+        uint32_t ps = irq_save();
+        tx_fill();
+        irq_restore(ps);
+    }
+}
+
 } /* extern "C" */
@@ -43,6 +43,20 @@ bool uart_rx_available(void);
  * No \n -> \r\n conversion, no mutex. For video bridge use. */
 void uart_write_raw(const uint8_t *buf, uint16_t len);
 
+/* Start sending buf in the background and return at once; the TX
+ * interrupt keeps the FIFO fed. buf must stay unchanged until
+ * uart_tx_busy() is false. Waits first if a previous write is still
+ * going. Other output (uart_putc, uart_write_raw) waits for it too. */
+void uart_write_async(const uint8_t *buf, uint16_t len);
+
+/* Is a background write still in progress? */
+bool uart_tx_busy(void);
+
+/* Wait for the background write to be queued in the TX FIFO. From a
+ * task this sleeps and yields while the TX interrupt works; with IRQs
+ * masked it feeds the FIFO itself. */
+void uart_tx_wait(void);
+
 #ifdef __cplusplus
 }
 #endif
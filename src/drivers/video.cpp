@@ -3,18 +3,239 @@
  *
  * 128x64 monochrome framebuffer (1KB RAM).
  * Bresenham line drawing for wireframe graphics (Elite, etc).
- * Output via UART "video bridge" — sync header + raw pixels.
+ * Output via UART "video bridge" — sync header + raw pixels, only
+ * the changed row spans against the last frame sent, or the drawing
+ * calls themselves as a display list.
+ *
+ * Two buffers: drawing goes to the back one, the front one holds the
+ * frame the viewer has. A flush codes the back buffer against the
+ * front, makes it the new front and leaves the UART interrupt sending
+ * it, so the next frame renders while this one drains.
+ *
+ * Drawing ORs pixels in, or XORs them (fb_set_rop). XOR draws are
+ * also listed per buffer so fb_erase() can draw them again to remove
+ * them: a frame then costs what moves, not a clear and a full redraw.
  */
 
 #include "drivers/video.h"
 #include "drivers/font.h"
 #include "drivers/uart.h"
+#include "kernel/task.h"
 
 extern "C" {
 
 /* ====== Framebuffer ====== */
 
-static uint8_t fb[FB_SIZE];  /* 128x64 pixels, 1 bit per pixel, row-major */
+/* 128x64 pixels, 1 bit per pixel, row-major, after 4 bytes of room
+ * for the sync header so a key frame goes out in one write */
+static uint8_t fb_mem[2][4 + FB_SIZE] __attribute__((aligned(4)));
+static int back = 0;                    /* fb_mem[back] is drawn into */
+static uint8_t *fb = fb_mem[0] + 4;     /* back buffer */
+static uint8_t *front = fb_mem[1] + 4;  /* last frame sent */
+static fb_flush_hook_t flush_hook = nullptr;
+
+/* Delta transfer state */
+static uint8_t tx_buf[6 + FB_SIZE];    /* sync, length, payload */
+static int mode = VIDEO_LIST;
+static int since_key = VIDEO_KEY_INTERVAL;  /* first flush is a key frame */
+static video_stats_t stats;
+
+/* Clip rectangle, inclusive */
+static int clip_x0 = 0, clip_y0 = 0;
+static int clip_x1 = FB_WIDTH - 1, clip_y1 = FB_HEIGHT - 1;
+
+static int rop_xor = 0;                 /* FB_ROP_XOR in effect */
+
+/* ====== Display lists ====== */
+
+/*
+ * A list of drawing calls in the bridge's list format (video.h). The
+ * frame being drawn is one, sent to the viewer: valid from an
+ * fb_clear() up to the next flush while every call could be recorded.
+ * Each buffer has two more: its XOR draws since its last fb_clear()
+ * or fb_erase(), which fb_erase() replays to take them off again, and
+ * its OR draws since fb_clear(), which is what is left after that, so
+ * an erased frame can still go out as a list.
+ */
+typedef struct {
+    uint8_t *buf;
+    int cap;
+    int len;
+    int valid;
+    int line_end;               /* y << 8 | x where the last line ended */
+    int text;                   /* offset of the open text command */
+    int text_x, text_y;         /* where its next char would go */
+    int clipped;                /* has a clip command */
+    int clip_at;                /* offset of the last one */
+} dlist_t;
+
+static uint8_t dl_buf[VIDEO_LIST_SIZE];
+static uint8_t xl_buf[2][VIDEO_ERASE_SIZE];
+static uint8_t bl_buf[2][VIDEO_BASE_SIZE];
+static dlist_t dl = { dl_buf, VIDEO_LIST_SIZE, 0, 0, -1, -1, 0, 0, 0, -1 };
+static dlist_t xl[2] = {                /* XOR draws, per buffer */
+    { xl_buf[0], VIDEO_ERASE_SIZE, 0, 0, -1, -1, 0, 0, 0, -1 },
+    { xl_buf[1], VIDEO_ERASE_SIZE, 0, 0, -1, -1, 0, 0, 0, -1 },
+};
+static dlist_t bl[2] = {                /* OR draws, per buffer */
+    { bl_buf[0], VIDEO_BASE_SIZE, 0, 0, -1, -1, 0, 0, 0, -1 },
+    { bl_buf[1], VIDEO_BASE_SIZE, 0, 0, -1, -1, 0, 0, 0, -1 },
+};
+static int dl_direct = 0;               /* fb_buffer() handed out since the last swap */
+
+/* Layer being drawn: fb and dl point at its pixels and list meanwhile */
+static fb_layer_t *layer = nullptr;
+static uint8_t *layer_fb;
+static dlist_t layer_dl;
+
+static inline int on_screen(int x, int y)
+{
+    return (unsigned)x < FB_WIDTH && (unsigned)y < FB_HEIGHT;
+}
+
+/* Room for n more bytes? Gives up on the list if not. */
+static int dl_room(dlist_t *d, int n)
+{
+    if (d->len + n > d->cap)
+        d->valid = 0;
+    return d->valid;
+}
+
+static void dl_put4(dlist_t *d, int op, int a, int b, int c, int e)
+{
+    uint8_t *q = d->buf + d->len;
+    q[0] = (uint8_t)op;
+    q[1] = (uint8_t)a;
+    q[2] = (uint8_t)b;
+    q[3] = (uint8_t)c;
+    q[4] = (uint8_t)e;
+    d->len += 5;
+}
+
+static void dl_clip(dlist_t *d)
+{
+    /* Straight after another one: replaces it */
+    if (d->clipped && d->clip_at + 5 == d->len)
+        d->len = d->clip_at;
+    if (!dl_room(d, 5)) return;
+    d->clip_at = d->len;
+    dl_put4(d, VIDEO_DL_CLIP, clip_x0, clip_y0, clip_x1, clip_y1);
+    d->line_end = -1;
+    d->text = -1;
+    d->clipped = 1;
+}
+
+static void dl_rop(dlist_t *d, int rop)
+{
+    if (!dl_room(d, 2)) return;
+    d->buf[d->len++] = VIDEO_DL_ROP;
+    d->buf[d->len++] = (uint8_t)rop;
+    d->line_end = -1;
+    d->text = -1;
+}
+
+/* Empty the list; it starts from an unclipped OR state */
+static void dl_reset(dlist_t *d, int valid)
+{
+    d->len = 0;
+    d->valid = valid;
+    d->line_end = -1;
+    d->text = -1;
+    d->clipped = 0;
+    if (clip_x0 != 0 || clip_y0 != 0 ||
+        clip_x1 != FB_WIDTH - 1 || clip_y1 != FB_HEIGHT - 1)
+        dl_clip(d);
+}
+
+static void dl_pixel(dlist_t *d, int x, int y)
+{
+    if (!dl_room(d, 3)) return;
+    d->buf[d->len++] = VIDEO_DL_PIXEL;
+    d->buf[d->len++] = (uint8_t)x;
+    d->buf[d->len++] = (uint8_t)y;
+    d->line_end = -1;
+    d->text = -1;
+}
+
+static void dl_line(dlist_t *d, int x0, int y0, int x1, int y1)
+{
+    if (on_screen(x0, y0) && on_screen(x1, y1)) {
+        if (d->line_end == (y0 << 8 | x0)) {
+            if (!dl_room(d, 3)) return;
+            d->buf[d->len++] = VIDEO_DL_LINE_TO;
+        } else {
+            if (!dl_room(d, 4)) return;
+            d->buf[d->len++] = (uint8_t)x0;     /* < 0x80: short line */
+            d->buf[d->len++] = (uint8_t)y0;
+        }
+        d->buf[d->len++] = (uint8_t)x1;
+        d->buf[d->len++] = (uint8_t)y1;
+        d->line_end = y1 << 8 | x1;
+    } else {
+        /* Endpoint off screen (projection): 16-bit coordinates */
+        int c[4] = { x0, y0, x1, y1 };
+        for (int i = 0; i < 4; i++)
+            if (c[i] < -32768 || c[i] > 32767) { d->valid = 0; return; }
+        if (!dl_room(d, 9)) return;
+        d->buf[d->len++] = VIDEO_DL_LINE16;
+        for (int i = 0; i < 4; i++) {
+            d->buf[d->len++] = (uint8_t)c[i];
+            d->buf[d->len++] = (uint8_t)(c[i] >> 8);
+        }
+        d->line_end = -1;
+    }
+    d->text = -1;
+}
+
+static void dl_char(dlist_t *d, int x, int y, char c)
+{
+    /* Extend the open text command if this char follows on */
+    if (d->text >= 0 && x == d->text_x && y == d->text_y && d->buf[d->text + 3] < 255) {
+        if (!dl_room(d, 1)) return;
+        d->buf[d->text + 3]++;
+    } else {
+        if (!on_screen(x, y)) { d->valid = 0; return; }
+        if (!dl_room(d, 5)) return;
+        d->text = d->len;
+        d->buf[d->len++] = VIDEO_DL_TEXT;
+        d->buf[d->len++] = (uint8_t)x;
+        d->buf[d->len++] = (uint8_t)y;
+        d->buf[d->len++] = 1;
+    }
+    d->buf[d->len++] = (uint8_t)c;
+    d->text_x = x + FONT_W;
+    d->text_y = y;
+    d->line_end = -1;
+}
+
+/* d = s, for lists of the same size */
+static void dl_copy(dlist_t *d, const dlist_t *s)
+{
+    uint8_t *buf = d->buf;
+    ets_memcpy(buf, s->buf, s->len);
+    *d = *s;
+    d->buf = buf;
+}
+
+/* The back buffer's list for the current raster op, if still valid */
+static inline dlist_t *buf_rec(void)
+{
+    if (layer)
+        return nullptr;
+    dlist_t *d = rop_xor ? &xl[back] : &bl[back];
+    return d->valid ? d : nullptr;
+}
+
+uint8_t *fb_buffer(void)
+{
+    /* Pixels written through the pointer cannot be listed */
+    dl.valid = 0;
+    if (!layer) {
+        dl_direct = 1;
+        bl[back].valid = 0;
+    }
+    return fb;
+}
 
 /* ====== Init ====== */
 
@@ -34,80 +255,432 @@ void video_init(void)
 
 void fb_clear(void)
 {
-    for (int i = 0; i < FB_SIZE; i++)
-        fb[i] = 0;
+    uint32_t *w = (uint32_t *)fb;
+    for (int i = 0; i < FB_SIZE / 4; i++)
+        w[i] = 0;
+
+    /* The viewer starts each list unclipped, in OR mode */
+    dl_reset(&dl, layer || !dl_direct);
+    if (rop_xor && dl.valid)
+        dl_rop(&dl, FB_ROP_XOR);
+    if (rop_xor && layer)
+        dl.valid = 0;               /* composited as OR: cannot replay */
+    if (!layer) {
+        dl_reset(&xl[back], 1);
+        dl_reset(&bl[back], 1);
+    }
+}
+
+static inline int in_clip(int x, int y)
+{
+    return x >= clip_x0 && x <= clip_x1 && y >= clip_y0 && y <= clip_y1;
+}
+
+static inline void put_pixel(int x, int y)
+{
+    if (!in_clip(x, y))
+        return;
+    uint8_t mask = (uint8_t)(0x80 >> (x & 7));
+    if (rop_xor)
+        fb[y * FB_STRIDE + (x >> 3)] ^= mask;
+    else
+        fb[y * FB_STRIDE + (x >> 3)] |= mask;
 }
 
 void fb_set_pixel(int x, int y)
 {
-    if ((unsigned)x >= FB_WIDTH || (unsigned)y >= FB_HEIGHT)
+    if (!in_clip(x, y))
         return;
-    fb[y * FB_STRIDE + (x >> 3)] |= (0x80 >> (x & 7));
+    put_pixel(x, y);
+
+    if (dl.valid)
+        dl_pixel(&dl, x, y);
+    if (dlist_t *b = buf_rec())
+        dl_pixel(b, x, y);
 }
 
 void fb_clear_pixel(int x, int y)
 {
-    if ((unsigned)x >= FB_WIDTH || (unsigned)y >= FB_HEIGHT)
+    if (!in_clip(x, y))
         return;
     fb[y * FB_STRIDE + (x >> 3)] &= ~(0x80 >> (x & 7));
+    dl.valid = 0;
+    if (!layer)
+        bl[back].valid = 0;
 }
 
-/* ====== Bresenham line drawing ====== */
+static void set_clip(int x0, int y0, int x1, int y1)
+{
+    clip_x0 = x0 < 0 ? 0 : x0;
+    clip_y0 = y0 < 0 ? 0 : y0;
+    clip_x1 = x1 > FB_WIDTH - 1 ? FB_WIDTH - 1 : x1;
+    clip_y1 = y1 > FB_HEIGHT - 1 ? FB_HEIGHT - 1 : y1;
+}
 
-void fb_line(int x0, int y0, int x1, int y1)
+void fb_set_clip(int x0, int y0, int x1, int y1)
 {
-    int dx = x1 - x0;
-    int dy = y1 - y0;
-    int sx = 1;
-    int sy = 1;
+    set_clip(x0, y0, x1, y1);
 
-    if (dx < 0) { dx = -dx; sx = -1; }
-    if (dy < 0) { dy = -dy; sy = -1; }
+    /* Buffer lists need it too, to replay draws with the same clip */
+    if (dl.valid)
+        dl_clip(&dl);
+    if (layer)
+        return;
+    if (xl[back].valid)
+        dl_clip(&xl[back]);
+    if (bl[back].valid)
+        dl_clip(&bl[back]);
+}
+
+void fb_reset_clip(void)
+{
+    fb_set_clip(0, 0, FB_WIDTH - 1, FB_HEIGHT - 1);
+}
+
+void fb_set_rop(int rop)
+{
+    rop_xor = rop == FB_ROP_XOR;
+    if (dl.valid)
+        dl_rop(&dl, rop);
+    if (rop_xor && layer)
+        dl.valid = 0;
+}
+
+/* ====== Layers ====== */
+
+void fb_layer_begin(fb_layer_t *l)
+{
+    layer = l;
+    layer_fb = fb;
+    layer_dl = dl;
+    fb = l->pix;
+    dl.buf = l->list;
+    dl.cap = VIDEO_LAYER_LIST;
+    fb_clear();
+}
+
+void fb_layer_end(void)
+{
+    fb_layer_t *l = layer;
+    if (!l)
+        return;
+    l->list_len = (uint16_t)dl.len;
+    l->list_ok = (uint8_t)dl.valid;
+    l->list_clip = (uint8_t)dl.clipped;
+    l->ready = 1;
+    fb = layer_fb;
+    dl = layer_dl;
+    layer = nullptr;
+}
+
+/* Add a layer's list to d: OR mode and no clip, as it was recorded */
+static void dl_append(dlist_t *d, const fb_layer_t *l)
+{
+    int cx0 = clip_x0, cy0 = clip_y0, cx1 = clip_x1, cy1 = clip_y1;
+    int full = cx0 == 0 && cy0 == 0 && cx1 == FB_WIDTH - 1 && cy1 == FB_HEIGHT - 1;
+
+    if (rop_xor)
+        dl_rop(d, FB_ROP_OR);
+    if (!full) {
+        set_clip(0, 0, FB_WIDTH - 1, FB_HEIGHT - 1);
+        dl_clip(d);
+        set_clip(cx0, cy0, cx1, cy1);
+    }
+    if (!dl_room(d, l->list_len))
+        return;
+    ets_memcpy(d->buf + d->len, l->list, l->list_len);
+    d->len += l->list_len;
+    d->line_end = -1;
+    d->text = -1;
+    if (!full || l->list_clip)
+        dl_clip(d);
+    if (rop_xor)
+        dl_rop(d, FB_ROP_XOR);
+}
+
+void fb_layer_draw(const fb_layer_t *l)
+{
+    /* Both buffers are word aligned: fb_mem rows start 4 bytes in */
+    const uint32_t *src = (const uint32_t *)l->pix;
+    uint32_t *dst = (uint32_t *)fb;
+    for (int i = 0; i < FB_SIZE / 4; i += 4) {
+        dst[i] |= src[i];
+        dst[i + 1] |= src[i + 1];
+        dst[i + 2] |= src[i + 2];
+        dst[i + 3] |= src[i + 3];
+    }
+
+    if (!l->list_ok) {
+        dl.valid = 0;
+        if (!layer)
+            bl[back].valid = 0;
+        return;
+    }
+    if (dl.valid)
+        dl_append(&dl, l);
+    if (!layer && bl[back].valid)
+        dl_append(&bl[back], l);
+}
+
+/* ====== Line drawing ====== */
+
+/* Horizontal run x0..x1 (x0 <= x1) on row y: whole bytes at a time */
+static void hline(int x0, int x1, int y)
+{
+    if (y < clip_y0 || y > clip_y1)
+        return;
+    if (x0 < clip_x0) x0 = clip_x0;
+    if (x1 > clip_x1) x1 = clip_x1;
+    if (x0 > x1)
+        return;
+
+    uint8_t *p = fb + y * FB_STRIDE + (x0 >> 3);
+    uint8_t *last = fb + y * FB_STRIDE + (x1 >> 3);
+    uint8_t first_mask = (uint8_t)(0xFF >> (x0 & 7));
+    uint8_t last_mask = (uint8_t)(0xFF << (7 - (x1 & 7)));
+    if (rop_xor) {
+        if (p == last) {
+            *p ^= first_mask & last_mask;
+            return;
+        }
+        *p++ ^= first_mask;
+        while (p < last)
+            *p++ ^= 0xFF;
+        *p ^= last_mask;
+        return;
+    }
+    if (p == last) {
+        *p |= first_mask & last_mask;
+        return;
+    }
+    *p++ |= first_mask;
+    while (p < last)
+        *p++ = 0xFF;
+    *p |= last_mask;
+}
+
+/* Vertical run y0..y1 (y0 <= y1) in column x */
+static void vline(int x, int y0, int y1)
+{
+    if (x < clip_x0 || x > clip_x1)
+        return;
+    if (y0 < clip_y0) y0 = clip_y0;
+    if (y1 > clip_y1) y1 = clip_y1;
 
-    int err;
+    uint8_t *p = fb + y0 * FB_STRIDE + (x >> 3);
+    uint8_t mask = (uint8_t)(0x80 >> (x & 7));
+    if (rop_xor) {
+        for (int y = y0; y <= y1; y++, p += FB_STRIDE)
+            *p ^= mask;
+    } else {
+        for (int y = y0; y <= y1; y++, p += FB_STRIDE)
+            *p |= mask;
+    }
+}
 
-    if (dx >= dy) {
-        /* Shallow line (more horizontal) */
-        err = dx >> 1;
-        for (int i = 0; i <= dx; i++) {
-            fb_set_pixel(x0, y0);
+/* Pixel loop of raster_line; xor is a constant at each call site so
+ * the compiler drops the test from the loop */
+static inline __attribute__((always_inline))
+void line_steps(uint8_t *p, uint8_t mask, int err, int n, int dx, int dy,
+                int sx, int ystep, int steep, const int xor_op)
+{
+    if (!steep) {
+        /* Shallow: x every pixel, y when the error runs out */
+        for (int i = 0; i <= n; i++) {
+            if (xor_op) *p ^= mask; else *p |= mask;
             err -= dy;
             if (err < 0) {
-                y0 += sy;
+                p += ystep;
                 err += dx;
             }
-            x0 += sx;
+            if (sx > 0) {
+                mask >>= 1;
+                if (!mask) { mask = 0x80; p++; }
+            } else {
+                mask <<= 1;
+                if (!mask) { mask = 0x01; p--; }
+            }
         }
     } else {
-        /* Steep line (more vertical) */
-        err = dy >> 1;
-        for (int i = 0; i <= dy; i++) {
-            fb_set_pixel(x0, y0);
+        /* Steep: y every pixel, x when the error runs out */
+        for (int i = 0; i <= n; i++) {
+            if (xor_op) *p ^= mask; else *p |= mask;
             err -= dx;
             if (err < 0) {
-                x0 += sx;
                 err += dy;
+                if (sx > 0) {
+                    mask >>= 1;
+                    if (!mask) { mask = 0x80; p++; }
+                } else {
+                    mask <<= 1;
+                    if (!mask) { mask = 0x01; p--; }
+                }
             }
-            y0 += sy;
+            p += ystep;
+        }
+    }
+}
+
+/*
+ * Bresenham, clipped before drawing. Step j along the major axis has
+ * taken k(j) = ceil((j * dmin - e0) / dmaj) minor steps (e0 = dmaj / 2
+ * is the starting error), so the first and last j inside the clip
+ * rectangle, and the error term there, follow directly. The pixels
+ * are exactly those of the unclipped line that fall inside; none off
+ * screen are visited. The loops then step a byte pointer and bit mask.
+ */
+static void raster_line(int x0, int y0, int x1, int y1)
+{
+    if (y0 == y1) {
+        if (x0 < x1) hline(x0, x1, y0); else hline(x1, x0, y0);
+        return;
+    }
+    if (x0 == x1) {
+        if (y0 < y1) vline(x0, y0, y1); else vline(x0, y1, y0);
+        return;
+    }
+
+    int dx = x1 - x0;
+    int dy = y1 - y0;
+    int sx = 1;
+    int sy = 1;
+    if (dx < 0) { dx = -dx; sx = -1; }
+    if (dy < 0) { dy = -dy; sy = -1; }
+
+    /* Major axis: the one stepped every pixel */
+    int steep = dy > dx;
+    int dmaj = steep ? dy : dx;
+    int dmin = steep ? dx : dy;
+    int e0 = dmaj >> 1;
+
+    int j0 = 0, j1 = dmaj, k = 0, err = e0;
+    if (!in_clip(x0, y0) || !in_clip(x1, y1)) {
+        /* Steps that keep each coordinate inside the clip range */
+        int m0 = steep ? y0 : x0, ms = steep ? sy : sx;
+        int n0 = steep ? x0 : y0, ns = steep ? sx : sy;
+        int mlo = steep ? clip_y0 : clip_x0, mhi = steep ? clip_y1 : clip_x1;
+        int nlo = steep ? clip_x0 : clip_y0, nhi = steep ? clip_x1 : clip_y1;
+
+        int jlo = ms > 0 ? mlo - m0 : m0 - mhi;
+        int jhi = ms > 0 ? mhi - m0 : m0 - mlo;
+        int klo = ns > 0 ? nlo - n0 : n0 - nhi;
+        int khi = ns > 0 ? nhi - n0 : n0 - nlo;
+        if (jlo < 0) jlo = 0;
+        if (jhi > dmaj) jhi = dmaj;
+        if (khi < 0 || jlo > jhi)
+            return;
+
+        /* k(j) >= klo and k(j) <= khi. Ends are within +-FB_COORD_MAX,
+         * so every term is under 2^31, and none is negative: unsigned
+         * 32-bit divides. */
+        if (klo > 0) {
+            uint32_t num = (uint32_t)klo * dmaj + e0 - dmaj + 1;
+            int j = (int)((num + dmin - 1) / (uint32_t)dmin);
+            if (j > jlo) jlo = j;
+        }
+        int j = (int)(((uint32_t)khi * dmaj + e0) / (uint32_t)dmin);
+        if (j < jhi) jhi = j;
+        if (jlo > jhi)
+            return;
+
+        j0 = jlo;
+        j1 = jhi;
+        k = (int)(((uint32_t)j0 * dmin - e0 + dmaj - 1) / (uint32_t)dmaj);
+        err = e0 - j0 * dmin + k * dmaj;
+        if (steep) {
+            y0 += sy * j0;
+            x0 += sx * k;
+        } else {
+            x0 += sx * j0;
+            y0 += sy * k;
         }
     }
+
+    uint8_t *p = fb + y0 * FB_STRIDE + (x0 >> 3);
+    uint8_t mask = (uint8_t)(0x80 >> (x0 & 7));
+    if (rop_xor)
+        line_steps(p, mask, err, j1 - j0, dx, dy, sx, sy * FB_STRIDE, steep, 1);
+    else
+        line_steps(p, mask, err, j1 - j0, dx, dy, sx, sy * FB_STRIDE, steep, 0);
+}
+
+void fb_line(int x0, int y0, int x1, int y1)
+{
+    if (x0 < -FB_COORD_MAX || x0 > FB_COORD_MAX || y0 < -FB_COORD_MAX || y0 > FB_COORD_MAX ||
+        x1 < -FB_COORD_MAX || x1 > FB_COORD_MAX || y1 < -FB_COORD_MAX || y1 > FB_COORD_MAX)
+        return;
+    if (dl.valid)
+        dl_line(&dl, x0, y0, x1, y1);
+    if (dlist_t *b = buf_rec())
+        dl_line(b, x0, y0, x1, y1);
+
+    raster_line(x0, y0, x1, y1);
 }
 
 /* ====== Text rendering ====== */
 
-void fb_putchar(int x, int y, char c)
+/* Glyph rows ORed (or XORed) in a byte at a time: a row is 4 bits,
+ * shifted to x & 7, spilling into the next byte past bit 4. xor is a
+ * constant at each call site, as in line_steps. */
+static inline __attribute__((always_inline))
+void glyph_rows(uint8_t *p, const uint8_t *glyph, int sh, const int xor_op)
+{
+    if ((sh & 3) == 0) {
+        /* Even column: the glyph is one nibble of each row byte */
+        for (int row = 0; row < FONT_H; row++, p += FB_STRIDE) {
+            uint8_t bits = (uint8_t)((glyph[row] & 0xF0) >> sh);
+            if (xor_op) *p ^= bits; else *p |= bits;
+        }
+        return;
+    }
+    for (int row = 0; row < FONT_H; row++, p += FB_STRIDE) {
+        uint8_t bits = glyph[row] & 0xF0;
+        uint8_t lo = (uint8_t)(bits >> sh);
+        uint8_t hi = (uint8_t)(bits << (8 - sh));
+        if (xor_op) {
+            p[0] ^= lo;
+            if (sh > 4) p[1] ^= hi;
+        } else {
+            p[0] |= lo;
+            if (sh > 4) p[1] |= hi;
+        }
+    }
+}
+
+static void raster_char(int x, int y, char c)
 {
-    if (c < FONT_FIRST || c > FONT_LAST)
-        c = '?';
     const uint8_t *glyph = font_4x6[c - FONT_FIRST];
 
-    for (int row = 0; row < FONT_H; row++) {
-        uint8_t bits = glyph[row];  /* pixels in bits 7:4 */
-        for (int col = 0; col < FONT_W; col++) {
-            if (bits & (0x80 >> col))
-                fb_set_pixel(x + col, y + row);
+    if (x < clip_x0 || x + FONT_W - 1 > clip_x1 ||
+        y < clip_y0 || y + FONT_H - 1 > clip_y1) {
+        /* Partly clipped: pixel by pixel */
+        for (int row = 0; row < FONT_H; row++) {
+            uint8_t bits = glyph[row];  /* pixels in bits 7:4 */
+            for (int col = 0; col < FONT_W; col++) {
+                if (bits & (0x80 >> col))
+                    put_pixel(x + col, y + row);
+            }
         }
+        return;
     }
+
+    uint8_t *p = fb + y * FB_STRIDE + (x >> 3);
+    if (rop_xor)
+        glyph_rows(p, glyph, x & 7, 1);
+    else
+        glyph_rows(p, glyph, x & 7, 0);
+}
+
+void fb_putchar(int x, int y, char c)
+{
+    if (c < FONT_FIRST || c > FONT_LAST)
+        c = '?';
+    if (dl.valid)
+        dl_char(&dl, x, y, c);
+    if (dlist_t *b = buf_rec())
+        dl_char(b, x, y, c);
+
+    raster_char(x, y, c);
 }
 
 void fb_puts_at(int x, int y, const char *str)
@@ -137,17 +710,233 @@ void fb_text_puts(int col, int row, const char *str)
     }
 }
 
+/* ====== Erase by redraw ====== */
+
+/* Draw a recorded list again (the erase list format: no ROP commands) */
+static void dl_replay(const uint8_t *b, int n)
+{
+    int i = 0, lx = 0, ly = 0;
+    while (i < n) {
+        uint8_t op = b[i];
+        if (op < 0x80) {
+            raster_line(b[i], b[i + 1], b[i + 2], b[i + 3]);
+            lx = b[i + 2];
+            ly = b[i + 3];
+            i += 4;
+        } else if (op == VIDEO_DL_LINE16) {
+            int c[4];
+            for (int k = 0; k < 4; k++)
+                c[k] = (int16_t)(b[i + 1 + 2 * k] | b[i + 2 + 2 * k] << 8);
+            raster_line(c[0], c[1], c[2], c[3]);
+            i += 9;
+        } else if (op == VIDEO_DL_LINE_TO) {
+            raster_line(lx, ly, b[i + 1], b[i + 2]);
+            lx = b[i + 1];
+            ly = b[i + 2];
+            i += 3;
+        } else if (op == VIDEO_DL_PIXEL) {
+            put_pixel(b[i + 1], b[i + 2]);
+            i += 3;
+        } else if (op == VIDEO_DL_TEXT) {
+            int x = b[i + 1], y = b[i + 2], cnt = b[i + 3];
+            for (int k = 0; k < cnt; k++, x += FONT_W)
+                raster_char(x, y, (char)b[i + 4 + k]);
+            i += 4 + cnt;
+        } else if (op == VIDEO_DL_CLIP) {
+            set_clip(b[i + 1], b[i + 2], b[i + 3], b[i + 4]);
+            i += 5;
+        } else {
+            break;
+        }
+    }
+}
+
+int fb_erase(void)
+{
+    if (layer)
+        return -1;
+
+    dlist_t *e = &xl[back];
+    int ok = e->valid;
+
+    if (ok && e->len) {
+        dl.valid = 0;
+
+        int cx0 = clip_x0, cy0 = clip_y0, cx1 = clip_x1, cy1 = clip_y1;
+        int old_rop = rop_xor;
+        set_clip(0, 0, FB_WIDTH - 1, FB_HEIGHT - 1);
+        rop_xor = 1;
+        dl_replay(e->buf, e->len);
+        rop_xor = old_rop;
+        set_clip(cx0, cy0, cx1, cy1);
+    }
+
+    dl_reset(e, 1);
+
+    /* What is left is the OR draws: the frame's list starts from those */
+    dlist_t *b = &bl[back];
+    if (ok && b->valid && !dl_direct) {
+        uint8_t *buf = dl.buf;
+        ets_memcpy(buf, b->buf, b->len);
+        dl = *b;
+        dl.buf = buf;
+        dl.cap = VIDEO_LIST_SIZE;
+        if (rop_xor)
+            dl_rop(&dl, FB_ROP_XOR);
+        if (dl.clipped || clip_x0 != 0 || clip_y0 != 0 ||
+            clip_x1 != FB_WIDTH - 1 || clip_y1 != FB_HEIGHT - 1)
+            dl_clip(&dl);
+    }
+    return ok ? 0 : -1;
+}
+
 /* ====== UART video bridge flush ====== */
 
+/*
+ * Code the rows that differ from the front buffer into tx_buf after the
+ * 6-byte header. Returns the payload length, or -1 once it may come
+ * to more than limit bytes (a span costs at most 2 + 2 * bytes).
+ */
+static int encode_delta(int limit)
+{
+    uint8_t *out = tx_buf + 6;
+    int n = 0;
+
+    for (int y = 0; y < FB_HEIGHT; y++) {
+        const uint8_t *row = fb + y * FB_STRIDE;
+        const uint8_t *old = front + y * FB_STRIDE;
+
+        int x0 = 0;
+        while (x0 < FB_STRIDE && row[x0] == old[x0]) x0++;
+        if (x0 == FB_STRIDE)
+            continue;
+        int x1 = FB_STRIDE - 1;
+        while (row[x1] == old[x1]) x1--;
+
+        if (n + 2 + 2 * (x1 - x0 + 1) > limit)
+            return -1;
+        out[n++] = (uint8_t)y;
+        out[n++] = (uint8_t)(x0 << 4 | (x1 - x0));
+        for (int x = x0; x <= x1; ) {
+            if (row[x]) {
+                out[n++] = row[x++];
+                continue;
+            }
+            int k = 0;
+            while (x <= x1 && row[x] == 0) { x++; k++; }
+            out[n++] = 0;
+            out[n++] = (uint8_t)k;
+        }
+    }
+    return n;
+}
+
+/* Send the back buffer; keep = leave its contents, else swap */
+static void present(int keep)
+{
+    /* tx_buf and the front buffer are in use until the last frame is out */
+    if (uart_tx_busy()) {
+        uint32_t t0 = get_tick_count();
+        uart_tx_wait();
+        stats.wait_ticks += get_tick_count() - t0;
+    }
+
+    /* Smallest of: the display list, a delta, the whole frame */
+    int n = -1;
+    uint8_t sync = VIDEO_SYNC_3_DELTA;
+    int list = mode == VIDEO_LIST && dl.valid;
+    if (mode != VIDEO_RAW && since_key < VIDEO_KEY_INTERVAL)
+        n = encode_delta(list ? dl.len - 1 : FB_SIZE - 2);
+    if (list && n < 0) {
+        ets_memcpy(tx_buf + 6, dl.buf, dl.len);
+        n = dl.len;
+        sync = VIDEO_SYNC_3_LIST;
+    }
+    dl.valid = 0;
+
+    if (keep) {
+        /* Same picture in both, so the same things to erase */
+        ets_memcpy(front, fb, FB_SIZE);
+        dl_copy(&xl[back ^ 1], &xl[back]);
+        dl_copy(&bl[back ^ 1], &bl[back]);
+    } else {
+        back ^= 1;
+        fb = fb_mem[back] + 4;
+        front = fb_mem[back ^ 1] + 4;
+        dl_direct = 0;                  /* old pointers now stale */
+    }
+
+    if (n >= 0) {
+        tx_buf[0] = VIDEO_SYNC_0;
+        tx_buf[1] = VIDEO_SYNC_1;
+        tx_buf[2] = VIDEO_SYNC_2;
+        tx_buf[3] = sync;
+        tx_buf[4] = (uint8_t)n;
+        tx_buf[5] = (uint8_t)(n >> 8);
+        uart_write_async(tx_buf, (uint16_t)(6 + n));
+        stats.bytes += 6 + n;
+        if (sync == VIDEO_SYNC_3_LIST) {
+            stats.list_frames++;
+            since_key = 0;              /* self-contained, like a key frame */
+        } else {
+            since_key++;
+        }
+    } else {
+        uint8_t *hdr = front - 4;
+        hdr[0] = VIDEO_SYNC_0;
+        hdr[1] = VIDEO_SYNC_1;
+        hdr[2] = VIDEO_SYNC_2;
+        hdr[3] = VIDEO_SYNC_3;
+        uart_write_async(hdr, 4 + FB_SIZE);
+        stats.bytes += 4 + FB_SIZE;
+        stats.key_frames++;
+        since_key = 0;
+    }
+    stats.frames++;
+
+    if (flush_hook)
+        flush_hook(front);
+}
+
 void fb_flush(void)
 {
-    static const uint8_t sync[] = {
-        VIDEO_SYNC_0, VIDEO_SYNC_1,
-        VIDEO_SYNC_2, VIDEO_SYNC_3
-    };
+    present(1);
+}
 
-    uart_write_raw(sync, 4);
-    uart_write_raw(fb, FB_SIZE);
+void fb_swap(void)
+{
+    present(0);
+}
+
+void fb_set_flush_hook(fb_flush_hook_t hook)
+{
+    flush_hook = hook;
+}
+
+void video_set_mode(int m)
+{
+    mode = m;
+    since_key = VIDEO_KEY_INTERVAL;
+}
+
+int video_mode(void)
+{
+    return mode;
+}
+
+void video_key_frame(void)
+{
+    since_key = VIDEO_KEY_INTERVAL;
+}
+
+video_stats_t *video_stats(void)
+{
+    return &stats;
+}
+
+void video_reset_stats(void)
+{
+    ets_memset(&stats, 0, sizeof(stats));
 }
 
 } /* extern "C" */
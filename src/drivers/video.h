@@ -3,6 +3,31 @@
  *
  * 128x64 monochrome framebuffer (1KB) with Bresenham line drawing.
  * Output via UART "video bridge" protocol for PC-side rendering.
+ *
+ * Bridge frames (decoded by tools/viewer.py):
+ *   key    00 FF 00 FF, then the 1024 framebuffer bytes
+ *   delta  00 FF 00 FE, payload length (2, little endian), then one
+ *          record per row that changed since the last frame sent:
+ *            row (1), first byte << 4 | (bytes - 1) (1), span data
+ *          Span data is the new bytes, with each run of k zero bytes
+ *          sent as 00 k.
+ *   list   00 FF 00 FD, payload length (2, little endian), then the
+ *          drawing calls since fb_clear(), for the viewer to replay
+ *          on a blank frame:
+ *            x0 y0 x1 y1      line, all on screen (x0 < 0x80)
+ *            80 x0 y0 x1 y1   line, 16-bit coordinates, clipped per pixel
+ *            81 x1 y1         line on from where the last one ended
+ *            82 x y           pixel
+ *            83 x y n c...    n chars of the 4x6 font from pixel (x, y)
+ *            84 x0 y0 x1 y1   clip rectangle from here on
+ *            85 rop           0 = OR pixels in, 1 = XOR (FB_ROP_*)
+ *
+ * In delta mode a key frame still goes out every VIDEO_KEY_INTERVAL
+ * frames, and whenever the delta would not be smaller, so a viewer
+ * started late catches up. List mode (the default) records the
+ * drawing calls as well as drawing them and sends whichever is
+ * smallest; a frame that was not drawn from fb_clear() through these
+ * calls alone (fb_clear_pixel, fb_buffer) goes as pixels.
  */
 #ifndef OSITO_VIDEO_H
 #define OSITO_VIDEO_H
@@ -24,6 +49,53 @@ extern "C" {
 #define VIDEO_SYNC_1  0xFF
 #define VIDEO_SYNC_2  0x00
 #define VIDEO_SYNC_3  0xFF
+#define VIDEO_SYNC_3_DELTA  0xFE    /* last sync byte of a delta frame */
+#define VIDEO_SYNC_3_LIST   0xFD    /* ... of a display list frame */
+
+/* Display list commands (a first byte below 0x80 is a short line) */
+#define VIDEO_DL_LINE16     0x80
+#define VIDEO_DL_LINE_TO    0x81
+#define VIDEO_DL_PIXEL      0x82
+#define VIDEO_DL_TEXT       0x83
+#define VIDEO_DL_CLIP       0x84
+#define VIDEO_DL_ROP        0x85
+
+/* Transfer modes */
+#define VIDEO_RAW           0       /* every frame in full */
+#define VIDEO_DELTA         1       /* changed row spans */
+#define VIDEO_LIST          2       /* display list when smaller */
+
+#define VIDEO_LIST_SIZE     512     /* list bytes per frame, else pixels */
+#define VIDEO_ERASE_SIZE    512     /* XOR draws fb_erase() can take back */
+#define VIDEO_BASE_SIZE     128     /* OR draws under them, for list frames */
+#define VIDEO_LAYER_LIST    128     /* a layer's draws, for list frames */
+
+/* Raster operations */
+#define FB_ROP_OR           0       /* set pixels (default) */
+#define FB_ROP_XOR          1       /* flip pixels: drawing twice erases */
+
+/* Delta mode: longest run of delta frames between key frames */
+#define VIDEO_KEY_INTERVAL  64
+
+typedef struct {
+    uint32_t frames;            /* fb_flush calls */
+    uint32_t key_frames;        /* sent in full */
+    uint32_t list_frames;       /* sent as display lists */
+    uint32_t bytes;             /* sent on the UART, sync included */
+    uint32_t wait_ticks;        /* flushes held up by the frame before */
+} video_stats_t;
+
+/* Off-screen layer: a framebuffer of its own for things that seldom
+ * change, drawn once and OR'd into frames with fb_layer_draw(). Keeps
+ * its drawing calls too, so frames using it still go out as lists. */
+typedef struct {
+    uint8_t pix[FB_SIZE] __attribute__((aligned(4)));
+    uint8_t list[VIDEO_LAYER_LIST];
+    uint16_t list_len;
+    uint8_t list_ok;            /* list holds every draw */
+    uint8_t list_clip;          /* list sets the clip */
+    uint8_t ready;              /* drawn; set to 0 when it changes */
+} fb_layer_t;
 
 /* Initialize video subsystem (clears framebuffer) */
 void video_init(void);
@@ -37,15 +109,79 @@ void fb_set_pixel(int x, int y);
 /* Clear a single pixel */
 void fb_clear_pixel(int x, int y);
 
-/* Draw a line using Bresenham's algorithm */
+/* Draw a line using Bresenham's algorithm. Clipped before drawing, so
+ * far off-screen ends cost nothing; same pixels as unclipped. Lines
+ * with an end beyond +-FB_COORD_MAX are not drawn: the clip works in
+ * 32-bit products, with no 64-bit divide. */
+#define FB_COORD_MAX  16383
 void fb_line(int x0, int y0, int x1, int y1);
 
-/* Flush framebuffer to UART (sync header + 1024 bytes) */
+/* Raster operation for pixels, lines and text: FB_ROP_OR or FB_ROP_XOR */
+void fb_set_rop(int rop);
+
+/* Remove everything drawn in XOR mode since the last fb_clear() or
+ * fb_erase() in this buffer, by drawing it again in XOR. Returns 0, or
+ * -1 if there was too much to keep track of (or the buffer has not
+ * been cleared yet): then fb_clear() and redraw everything.
+ *
+ *   if (fb_erase() < 0) { fb_clear(); draw_static(); }
+ *   fb_set_rop(FB_ROP_XOR); draw_moving(); fb_set_rop(FB_ROP_OR);
+ *   fb_swap();
+ *
+ * Each buffer keeps its own list, so this works with fb_swap(). Where
+ * an even number of XOR draws cross, the pixel stays off. Draw in OR
+ * mode only before the XOR draws of a buffer: XOR cannot erase what
+ * an OR draw covered since. */
+int fb_erase(void);
+
+/* Draw into a layer instead of the framebuffer, from fb_layer_begin()
+ * (which clears it) to fb_layer_end(), which marks it ready. The draw
+ * calls all work; fb_erase() and flushing do not belong in between. */
+void fb_layer_begin(fb_layer_t *layer);
+void fb_layer_end(void);
+
+/* OR a layer into the framebuffer, a 32-bit word at a time, whatever
+ * the clip and raster op. It counts as an OR draw (see fb_erase). */
+void fb_layer_draw(const fb_layer_t *layer);
+
+/* Keep pixels, lines and text inside x0..x1, y0..y1 (inclusive,
+ * limited to the screen) until reset. fb_clear() does not reset it. */
+void fb_set_clip(int x0, int y0, int x1, int y1);
+void fb_reset_clip(void);
+
+/* Send the framebuffer to the UART (key or delta frame). Returns once
+ * the frame is captured; the UART sends it in the background while
+ * the next one is drawn. Waits only if the previous frame is still
+ * going out. The framebuffer keeps its contents. */
 void fb_flush(void);
 
+/* As fb_flush, but flips the two buffers instead of copying: drawing
+ * continues in the other buffer, which holds the frame before last.
+ * For loops that clear and redraw every frame. fb_buffer() changes. */
+void fb_swap(void);
+
+/* Transfer mode, VIDEO_RAW / VIDEO_DELTA / VIDEO_LIST (default) */
+void video_set_mode(int mode);
+int video_mode(void);
+
+/* Make the next fb_flush() send a key frame */
+void video_key_frame(void);
+
+video_stats_t *video_stats(void);
+void video_reset_stats(void);
+
+/* Direct access to the 1024-byte back buffer (row-major, MSB = left).
+ * Frames go out as pixels from here until the next fb_swap(). */
+uint8_t *fb_buffer(void);
+
+/* Called by fb_flush()/fb_swap() with each frame sent (frame recorder).
+ * nullptr removes the hook. */
+typedef void (*fb_flush_hook_t)(const uint8_t *fb);
+void fb_set_flush_hook(fb_flush_hook_t hook);
+
 /* ====== Text rendering (requires font.h) ====== */
 
-/* Draw a single character at pixel coordinates (OR-compositing) */
+/* Draw a single character at pixel coordinates (OR or XOR, fb_set_rop) */
 void fb_putchar(int x, int y, char c);
 
 /* Draw a string at pixel coordinates (no wrapping) */
@@ -14,6 +14,7 @@
 #include "fs/ositofs.h"
 #include "gfx/wire3d.h"
 #include "gfx/ships.h"
+#include "gfx/wmodel.h"
 
 extern "C" {
 
@@ -40,6 +41,8 @@ static const char core_zf[] =
     ": delay     135 sys ; "
     ": wire-render 136 sys ; "
     ": wire-models 137 sys ; "
+    ": files     138 sys ; "
+    ": model-load 139 sys ; "
     /* Dictionary access shortcuts */
     ": !    0 !! ; "
     ": @    0 @@ ; "
@@ -237,23 +240,55 @@ zf_input_state zf_host_sys(zf_ctx *ctx, zf_syscall_id id, const char *last_word)
         uint8_t ry = (uint8_t)zf_pop(ctx);
         uint8_t rx = (uint8_t)zf_pop(ctx);
         int idx = (int)zf_pop(ctx);
-        /* 0=cube, 1-4=ships */
-        const wire_model_t *m = &wire_cube;
-        if (idx >= 1 && idx <= SHIP_COUNT)
-            m = ship_list[idx - 1];
+        /* 0=cube, 1-4=ships, then models loaded from files */
+        const wire_model_t *m = wmodel_at(idx);
+        if (!m)
+            m = &wire_cube;
         mat3_t rot;
-        mat3_rotate_x(&rot, rx);
-        mat3_t ry_m; mat3_rotate_y(&ry_m, ry);
-        mat3_t tmp; mat3_multiply(&tmp, &ry_m, &rot);
-        mat3_t rz_m; mat3_rotate_z(&rz_m, rz);
-        mat3_multiply(&rot, &rz_m, &tmp);
+        mat3_rotate_zyx(&rot, rx, ry, rz);
         vec3_t pos = vec3(0, 0, FIX16(6));
         wire_render(m, &rot, pos, FIX16(64));
         break;
     }
 
     case ZF_SYSCALL_USER + 9: { /* wire-models ( -- n ) */
-        zf_push(ctx, SHIP_COUNT + 1); /* cube + ships */
+        zf_push(ctx, wmodel_total()); /* cube + ships + loaded */
+        break;
+    }
+
+    case ZF_SYSCALL_USER + 10: { /* files ( addr len -- n ) */
+        zf_cell len = zf_pop(ctx);
+        zf_addr addr = zf_pop(ctx);
+        /* Pattern as for 'fs ls': "dir/" or a name prefix */
+        char pat[FS_PATH_LEN];
+        int n = (len >= FS_PATH_LEN) ? FS_PATH_LEN - 1 : (int)len;
+        for (int i = 0; i < n; i++)
+            pat[i] = (addr + i < ZF_DICT_SIZE) ? (char)ctx->dict[addr + i] : '?';
+        pat[n] = '\0';
+
+        fs_dir_t d;
+        fs_dirinfo_t info;
+        int count = 0;
+        if (fs_opendir(&d, pat) == 0) {
+            while (fs_readdir(&d, &info) > 0) {
+                uart_puts(info.name);
+                uart_puts(info.type == FS_TYPE_DIR ? "/\n" : "\n");
+                count++;
+            }
+        }
+        zf_push(ctx, count);
+        break;
+    }
+
+    case ZF_SYSCALL_USER + 11: { /* model-load ( addr len -- idx ) */
+        zf_cell len = zf_pop(ctx);
+        zf_addr addr = zf_pop(ctx);
+        char path[FS_PATH_LEN];
+        int n = (len >= FS_PATH_LEN) ? FS_PATH_LEN - 1 : (int)len;
+        for (int i = 0; i < n; i++)
+            path[i] = (addr + i < ZF_DICT_SIZE) ? (char)ctx->dict[addr + i] : '?';
+        path[n] = '\0';
+        zf_push(ctx, wmodel_load(path));    /* -1 on error */
         break;
     }
 
@@ -0,0 +1,181 @@
+/*
+ * OsitoFS - Flash read cache
+ *
+ * One heap block holds the page table followed by the page data:
+ *   [meta[0..n-1]][page 0][page 1]...
+ * Lookup is a linear scan (a handful of pages). Replacement is LRU by
+ * access stamp. A miss on the page right after the previous miss starts
+ * a sequential stream and also loads the next page; reaching that
+ * read-ahead page loads the one after it, and so on.
+ *
+ * Not reentrant: called from the filesystem, which serializes access.
+ */
+
+#include "fs/fcache.h"
+#include "mem/heap.h"
+
+extern "C" {
+
+#define NO_PAGE     0xFFFFFFFF
+
+typedef struct {
+    uint32_t addr;              /* flash address of the page, or NO_PAGE */
+    uint32_t stamp;             /* last access, for LRU */
+} fcache_meta_t;
+
+static fcache_meta_t *meta = nullptr;
+static uint8_t *pages = nullptr;
+static uint32_t npages = 0;
+static uint32_t page_size = 0;
+static uint32_t heap_bytes = 0;
+static uint32_t lru_clock = 0;
+static uint32_t last_miss = NO_PAGE;
+static uint32_t ra_page = NO_PAGE;     /* last page loaded by read-ahead */
+static fcache_stats_t stats;
+
+int fcache_config(uint32_t bytes, uint32_t page)
+{
+    if (meta) {
+        heap_free(meta);
+        meta = nullptr;
+        pages = nullptr;
+    }
+    npages = 0;
+    page_size = 0;
+    heap_bytes = 0;
+    last_miss = NO_PAGE;
+    ra_page = NO_PAGE;
+
+    if (bytes == 0)
+        return 0;
+    if (page < 256 || page > 4096 || (page & (page - 1)))
+        return -1;
+
+    uint32_t n = bytes / (page + sizeof(fcache_meta_t));
+    if (n == 0)
+        return -1;
+
+    uint32_t total = n * (page + sizeof(fcache_meta_t));
+    void *mem = heap_alloc(total);
+    if (!mem)
+        return -1;
+
+    meta = (fcache_meta_t *)mem;
+    pages = (uint8_t *)mem + n * sizeof(fcache_meta_t);
+    for (uint32_t i = 0; i < n; i++) {
+        meta[i].addr = NO_PAGE;
+        meta[i].stamp = 0;
+    }
+    npages = n;
+    page_size = page;
+    heap_bytes = total;
+    return 0;
+}
+
+/* Find the page holding addr, loading it into the LRU slot on a miss */
+static uint8_t *get_page(uint32_t pa, int demand)
+{
+    uint32_t victim = 0;
+    for (uint32_t i = 0; i < npages; i++) {
+        if (meta[i].addr == pa) {
+            meta[i].stamp = ++lru_clock;
+            if (demand) stats.hits++;
+            return pages + i * page_size;
+        }
+        if (meta[i].addr == NO_PAGE ||
+            (meta[victim].addr != NO_PAGE && meta[i].stamp < meta[victim].stamp))
+            victim = i;
+    }
+
+    uint8_t *p = pages + victim * page_size;
+    SPIRead(pa, p, page_size);
+    meta[victim].addr = pa;
+    meta[victim].stamp = ++lru_clock;
+    if (demand) stats.misses++;
+    else stats.readahead++;
+    return p;
+}
+
+int fcache_read(uint32_t addr, void *dst, uint32_t len)
+{
+    /* Big transfers would only evict everything: read them directly */
+    if (npages == 0)
+        return -1;
+    if (len > npages * page_size / 2) {
+        stats.bypass++;
+        return -1;
+    }
+
+    uint8_t *d = (uint8_t *)dst;
+    while (len > 0) {
+        uint32_t pa = addr & ~(page_size - 1);
+        uint32_t off = addr - pa;
+        uint32_t n = page_size - off;
+        if (n > len) n = len;
+
+        uint32_t misses = stats.misses;
+        uint8_t *p = get_page(pa, 1);
+        int seq = pa == ra_page;
+        if (stats.misses != misses) {
+            seq = pa == last_miss + page_size;
+            last_miss = pa;
+        }
+        /* Sequential access: keep one page ahead of the reader */
+        if (seq && npages > 1 && pa + page_size < FS_FLASH_END) {
+            ra_page = pa + page_size;
+            get_page(ra_page, 0);
+        }
+
+        ets_memcpy(d, p + off, n);
+        addr += n;
+        d += n;
+        len -= n;
+    }
+    return 0;
+}
+
+void fcache_invalidate(uint32_t addr, uint32_t len)
+{
+    for (uint32_t i = 0; i < npages; i++) {
+        uint32_t pa = meta[i].addr;
+        if (pa != NO_PAGE && pa < addr + len && addr < pa + page_size) {
+            meta[i].addr = NO_PAGE;
+            stats.invalidated++;
+        }
+    }
+}
+
+void fcache_invalidate_all(void)
+{
+    for (uint32_t i = 0; i < npages; i++)
+        meta[i].addr = NO_PAGE;
+    last_miss = NO_PAGE;
+    ra_page = NO_PAGE;
+}
+
+uint32_t fcache_pages(void)
+{
+    return npages;
+}
+
+uint32_t fcache_page_size(void)
+{
+    return page_size;
+}
+
+uint32_t fcache_heap_bytes(void)
+{
+    return heap_bytes;
+}
+
+fcache_stats_t *fcache_stats(void)
+{
+    return &stats;
+}
+
+void fcache_reset_stats(void)
+{
+    ets_memset(&stats, 0, sizeof(stats));
+}
+
+} /* extern "C" */
@@ -0,0 +1,63 @@
+/*
+ * OsitoFS - Flash read cache
+ *
+ * Small LRU cache of flash pages (256 bytes to 4KB) in front of the
+ * ROM SPIRead. Sequential misses pull in the following page as well
+ * (read-ahead). Every flash write or erase done by the filesystem
+ * invalidates the pages it touches, so cached data is never stale.
+ *
+ * The cache memory comes from the heap; its budget is set at boot from
+ * FS_CACHE_BYTES / FS_CACHE_PAGE and can be changed at run time
+ * ('fs cache BYTES [PAGE]'). A budget of 0 disables it.
+ *
+ * Usage:
+ *   fcache_config(1024, 256);          // 4 pages of 256 bytes
+ *   if (fcache_read(addr, buf, n) < 0) // not cached: read directly
+ *       SPIRead(addr, buf, n);
+ *   fcache_invalidate(addr, n);        // after writing/erasing flash
+ */
+#ifndef OSITO_FCACHE_H
+#define OSITO_FCACHE_H
+
+#include "osito.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint32_t hits;              /* page lookups served from RAM */
+    uint32_t misses;            /* pages loaded on demand */
+    uint32_t readahead;         /* pages loaded ahead of a sequential read */
+    uint32_t invalidated;       /* pages dropped by writes/erases */
+    uint32_t bypass;            /* reads too large to cache */
+} fcache_stats_t;
+
+/* (Re)size the cache: bytes of heap in total (data + 8 bytes per page),
+ * page a power of two from 256 to 4096. bytes == 0 disables the cache.
+ * Returns 0, or -1 on bad arguments / no heap (cache left disabled). */
+int fcache_config(uint32_t bytes, uint32_t page);
+
+/* Copy len bytes at flash addr into dst through the cache.
+ * Returns 0, or -1 if the cache is off or the read is too large
+ * (caller reads flash directly). */
+int fcache_read(uint32_t addr, void *dst, uint32_t len);
+
+/* Drop cached pages overlapping [addr, addr+len) */
+void fcache_invalidate(uint32_t addr, uint32_t len);
+
+/* Drop every cached page */
+void fcache_invalidate_all(void);
+
+/* Geometry and counters */
+uint32_t fcache_pages(void);
+uint32_t fcache_page_size(void);
+uint32_t fcache_heap_bytes(void);
+fcache_stats_t *fcache_stats(void);
+void fcache_reset_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OSITO_FCACHE_H */
@@ -0,0 +1,243 @@
+/*
+ * OsitoFS - Flash I/O service task
+ *
+ * The queue carries pointers to caller-owned requests. The task takes
+ * the bus lock per operation (per flash page for programs), so a reader
+ * in another task waits for at most one erase and never sees the chip
+ * busy.
+ *
+ * Erases in the task bypass the ROM's SPIEraseSector, which spins for
+ * the whole erase, and drive the SPI0 controller directly: write
+ * enable, sector erase, then poll the status register's WIP bit with a
+ * one-tick sleep between polls. The flash cache is off while the bus
+ * is held, and flash-mapped code only runs under flashio_code_lock, so
+ * nothing else needs the flash while it is busy.
+ */
+
+#include "fs/flashio.h"
+#include "fs/fcache.h"
+#include "kernel/mq.h"
+#include "kernel/task.h"
+
+extern "C" {
+
+#define FLASH_PAGE  256                 /* program granularity of the chip */
+
+static flashio_req_t *queue_buf[FLASHIO_QUEUE_LEN];
+static mq_t queue;
+static mutex_t bus;
+static volatile int running = 0;       /* service task has started */
+static flashio_stats_t stats;
+
+void flashio_init(void)
+{
+    mq_init(&queue, queue_buf, sizeof(flashio_req_t *), FLASHIO_QUEUE_LEN);
+    mutex_init(&bus);
+}
+
+/* Is there flash-mapped code in the image? Without it the cache is
+ * never used and need not be toggled around every access. */
+static int irom_code(void)
+{
+#ifdef OSITO_HOST
+    return 0;
+#else
+    extern char _irom0_text_start[], _irom0_text_end[];
+    return (uint32_t)_irom0_text_end != (uint32_t)_irom0_text_start;
+#endif
+}
+
+void flashio_lock(void)
+{
+    mutex_lock(&bus);
+    if (irom_code())
+        Cache_Read_Disable();
+}
+
+void flashio_unlock(void)
+{
+    if (irom_code())
+        Cache_Read_Enable(0, 0, 1);
+    mutex_unlock(&bus);
+}
+
+void flashio_code_lock(void)
+{
+    mutex_lock(&bus);
+}
+
+void flashio_code_unlock(void)
+{
+    mutex_unlock(&bus);
+}
+
+/* ====== SPI0 direct access (service task only) ====== */
+
+static uint32_t spi_status(void)
+{
+    SPI0_RD_STATUS = 0;
+    SPI0_CMD = SPI_CMD_RDSR;
+    while (SPI0_CMD) {}
+    return SPI0_RD_STATUS;
+}
+
+/* Start a sector erase and sleep until the chip finishes it */
+static void erase_polled(uint32_t addr)
+{
+    while (spi_status() & SPI_SR_WIP) {}
+    do {
+        SPI0_CMD = SPI_CMD_WREN;
+        while (SPI0_CMD) {}
+    } while (!(spi_status() & SPI_SR_WEL));
+
+    SPI0_ADDR = addr & 0x00FFFFFF;
+    SPI0_CMD = SPI_CMD_SE;
+    while (SPI0_CMD) {}
+
+    while (spi_status() & SPI_SR_WIP) {
+        task_delay_ticks(1);
+        stats.erase_ticks++;
+    }
+}
+
+/* ====== Request execution ====== */
+
+static int do_erase(uint32_t addr, int in_task)
+{
+    int rc = 0;
+    addr &= ~(uint32_t)(FS_SECTOR_SIZE - 1);
+
+    flashio_lock();
+    if (in_task)
+        erase_polled(addr);
+    else
+        rc = SPIEraseSector(addr / FS_SECTOR_SIZE) ? -1 : 0;
+    fcache_invalidate(addr, FS_SECTOR_SIZE);
+    flashio_unlock();
+
+    stats.erases++;
+    return rc;
+}
+
+static int do_program(uint32_t addr, const void *buf, uint32_t len, int in_task)
+{
+    const uint8_t *p = (const uint8_t *)buf;
+    int rc = 0;
+
+    stats.programs++;
+    stats.program_bytes += len;
+
+    if (!in_task) {
+        flashio_lock();
+        rc = SPIWrite(addr, p, len) ? -1 : 0;
+        fcache_invalidate(addr, len);
+        flashio_unlock();
+        return rc;
+    }
+
+    /* One flash page per bus hold; let the other tasks in between */
+    while (len > 0 && rc == 0) {
+        uint32_t n = FLASH_PAGE - (addr & (FLASH_PAGE - 1));
+        if (n > len) n = len;
+
+        flashio_lock();
+        rc = SPIWrite(addr, p, n) ? -1 : 0;
+        fcache_invalidate(addr, n);
+        flashio_unlock();
+
+        addr += n;
+        p += n;
+        len -= n;
+        if (len) task_yield();
+    }
+    return rc;
+}
+
+static void run_request(flashio_req_t *r, int in_task)
+{
+    int rc;
+    if (r->op == FLASHIO_ERASE)
+        rc = do_erase(r->addr, in_task);
+    else if (r->op == FLASHIO_PROGRAM)
+        rc = do_program(r->addr, r->buf, r->len, in_task);
+    else
+        rc = -1;
+
+    r->status = (int8_t)rc;
+    if (r->done)
+        sem_post(r->done);
+}
+
+void flashio_task(void *arg)
+{
+    (void)arg;
+    running = 1;
+    for (;;) {
+        flashio_req_t *r;
+        mq_recv(&queue, &r);
+        run_request(r, 1);
+    }
+}
+
+/* ====== Submission ====== */
+
+void flashio_req_init(flashio_req_t *r, uint8_t op, uint32_t addr,
+                      const void *buf, uint32_t len, sem_t *done)
+{
+    r->op = op;
+    r->status = FLASHIO_PENDING;
+    r->addr = addr;
+    r->buf = buf;
+    r->len = len;
+    r->done = done;
+}
+
+void flashio_submit(flashio_req_t *r)
+{
+    r->status = FLASHIO_PENDING;
+    if (!running) {
+        run_request(r, 0);
+        return;
+    }
+
+    mq_send(&queue, &r);
+    uint16_t depth = mq_count(&queue);
+    if (depth > stats.queue_peak)
+        stats.queue_peak = depth;
+}
+
+int flashio_wait(flashio_req_t *r)
+{
+    if (r->done)
+        sem_wait(r->done);
+    while (r->status == FLASHIO_PENDING)
+        task_yield();
+    return r->status;
+}
+
+static int run_sync(uint8_t op, uint32_t addr, const void *buf, uint32_t len)
+{
+    flashio_req_t r;
+    sem_t done;
+    sem_init(&done, 0);
+    flashio_req_init(&r, op, addr, buf, len, &done);
+    flashio_submit(&r);
+    return flashio_wait(&r);
+}
+
+int flashio_erase(uint32_t addr)
+{
+    return run_sync(FLASHIO_ERASE, addr, nullptr, 0);
+}
+
+int flashio_program(uint32_t addr, const void *buf, uint32_t len)
+{
+    return run_sync(FLASHIO_PROGRAM, addr, buf, len);
+}
+
+flashio_stats_t *flashio_stats(void)
+{
+    return &stats;
+}
+
+} /* extern "C" */
@@ -0,0 +1,107 @@
+/*
+ * OsitoFS - Flash I/O service task
+ *
+ * Erase and program operations are queued to a dedicated task instead
+ * of running in the caller. A sector erase takes ~45 ms: the service
+ * task issues the command and then sleeps a tick at a time until the
+ * chip reports it done, so other tasks keep running and interrupts stay
+ * enabled. Programs go out one 256-byte flash page at a time with a
+ * yield in between.
+ *
+ * A request is owned by the caller until it completes; completion is
+ * signalled through the optional semaphore. Requests run in submission
+ * order, so an erase followed by a program of the same sector is safe
+ * without waiting in between.
+ *
+ * Before the task runs (boot, host tools) requests execute inline in
+ * the caller with the ROM routines.
+ *
+ * Every SPI access must hold the bus lock (flashio_lock), which also
+ * guards the read cache: the service task holds it for the whole of an
+ * erase and drops cached pages it overwrites.
+ *
+ * Flash-mapped (ICACHE_FLASH_ATTR) code is fetched over the same bus.
+ * flashio_lock turns the flash cache off while held, and callers into
+ * flash-mapped code hold flashio_code_lock, so neither side can run
+ * while the other has the bus.
+ *
+ * Usage:
+ *   flashio_req_t r;
+ *   sem_t done;
+ *   sem_init(&done, 0);
+ *   flashio_req_init(&r, FLASHIO_PROGRAM, addr, buf, len, &done);
+ *   flashio_submit(&r);                // returns at once
+ *   ...                                // keep working
+ *   flashio_wait(&r);                  // 0 or -1
+ *
+ *   flashio_erase(addr);               // synchronous helpers
+ *   flashio_program(addr, buf, len);
+ */
+#ifndef OSITO_FLASHIO_H
+#define OSITO_FLASHIO_H
+
+#include "osito.h"
+#include "kernel/sem.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FLASHIO_ERASE       1   /* erase the 4KB sector containing addr */
+#define FLASHIO_PROGRAM     2   /* program len bytes (aligned) at addr */
+
+#define FLASHIO_PENDING     1   /* status while queued or running */
+
+typedef struct {
+    uint8_t          op;        /* FLASHIO_ERASE / FLASHIO_PROGRAM */
+    volatile int8_t  status;    /* FLASHIO_PENDING, then 0 or -1 */
+    uint32_t         addr;
+    const void      *buf;       /* program source, 4-byte aligned */
+    uint32_t         len;
+    sem_t           *done;      /* posted on completion, may be null */
+} flashio_req_t;
+
+typedef struct {
+    uint32_t erases;
+    uint32_t programs;
+    uint32_t program_bytes;
+    uint32_t erase_ticks;       /* ticks slept waiting for erases */
+    uint16_t queue_peak;        /* deepest queue seen */
+} flashio_stats_t;
+
+/* Set up the request queue and bus lock (before any flash access) */
+void flashio_init(void);
+
+/* Service task body; create it with task_create() */
+void flashio_task(void *arg);
+
+/* Fill in a request */
+void flashio_req_init(flashio_req_t *r, uint8_t op, uint32_t addr,
+                      const void *buf, uint32_t len, sem_t *done);
+
+/* Queue a request. Blocks only while the queue is full. */
+void flashio_submit(flashio_req_t *r);
+
+/* Wait for a request to finish. Returns its status (0 or -1). */
+int flashio_wait(flashio_req_t *r);
+
+/* Synchronous erase / program. Return 0 or -1. */
+int flashio_erase(uint32_t addr);
+int flashio_program(uint32_t addr, const void *buf, uint32_t len);
+
+/* SPI bus lock for direct reads (SPIRead, read cache) */
+void flashio_lock(void);
+void flashio_unlock(void);
+
+/* Bus lock around calls into flash-mapped code (cache left on). The
+ * code must not touch the filesystem: the lock is not recursive. */
+void flashio_code_lock(void);
+void flashio_code_unlock(void);
+
+flashio_stats_t *flashio_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OSITO_FLASHIO_H */
@@ -0,0 +1,86 @@
+/*
+ * OsitoFS - LZSS decompressor
+ *
+ * See lzss.h for the stream format. Decoding is a small state machine
+ * so a caller can ask for any number of bytes at a time: a back-reference
+ * cut short by the end of the output buffer resumes on the next call.
+ */
+
+#include "fs/lzss.h"
+
+extern "C" {
+
+void lzss_dec_init(lzss_dec_t *d, lzss_fill_t fill, void *ctx)
+{
+    ets_memset(d->win, 0, LZSS_WINDOW);
+    d->fill = fill;
+    d->ctx = ctx;
+    d->bits = 0;
+    d->nbits = 0;
+    d->wpos = 0;
+    d->in_pos = 0;
+    d->in_len = 0;
+    d->copy_dist = 0;
+    d->copy_len = 0;
+    d->eof = 0;
+}
+
+/* Top up the accumulator to at least n bits. Returns 0, or -1 at end. */
+static int need_bits(lzss_dec_t *d, int n)
+{
+    while (d->nbits < n) {
+        if (d->in_pos >= d->in_len) {
+            if (d->eof) return -1;
+            d->in_len = (uint8_t)d->fill(d->ctx, d->in, LZSS_INBUF);
+            d->in_pos = 0;
+            if (d->in_len == 0) {
+                d->eof = 1;
+                return -1;
+            }
+        }
+        d->bits = (d->bits << 8) | d->in[d->in_pos++];
+        d->nbits += 8;
+    }
+    return 0;
+}
+
+static uint32_t take_bits(lzss_dec_t *d, int n)
+{
+    d->nbits -= n;
+    uint32_t v = (d->bits >> d->nbits) & ((1u << n) - 1);
+    d->bits &= (1u << d->nbits) - 1;
+    return v;
+}
+
+uint32_t lzss_decode(lzss_dec_t *d, uint8_t *out, uint32_t n)
+{
+    uint32_t done = 0;
+
+    while (done < n) {
+        if (d->copy_len) {
+            /* Continue a back-reference */
+            uint8_t c = d->win[(uint8_t)(d->wpos - d->copy_dist)];
+            d->win[d->wpos++] = c;
+            out[done++] = c;
+            d->copy_len--;
+            continue;
+        }
+
+        /* Flag + the larger of the two token bodies (12 bits) */
+        if (need_bits(d, 9) < 0)
+            break;
+        if (take_bits(d, 1)) {
+            uint8_t c = (uint8_t)take_bits(d, 8);
+            d->win[d->wpos++] = c;
+            out[done++] = c;
+        } else {
+            if (need_bits(d, 12) < 0)
+                break;
+            d->copy_dist = (uint16_t)(take_bits(d, 8) + 1);
+            d->copy_len = (uint8_t)(take_bits(d, 4) + LZSS_MIN_MATCH);
+        }
+    }
+    return done;
+}
+
+} /* extern "C" */
@@ -0,0 +1,66 @@
+/*
+ * OsitoFS - LZSS decompressor for compressed files
+ *
+ * Small-window LZ77 (heatshrink-style) bit stream, MSB first:
+ *   1 + 8 bits            literal byte
+ *   0 + 8 bits + 4 bits   back-reference: distance-1 (1..256),
+ *                         length-2 (2..17)
+ * The stream has no end marker; the decoder is told the raw size.
+ * Trailing bits in the last byte are zero.
+ *
+ * The decoder is streaming and resumable: it keeps a 256-byte history
+ * window and a 32-byte input buffer (~300 bytes in total) and pulls
+ * compressed bytes through a fill callback, so files of any size are
+ * decoded without buffering them whole.
+ *
+ * The encoder lives in the host tools (tools/ositofs/lzss_enc.cpp and
+ * tools/upload.py); only the decoder is linked into the kernel.
+ *
+ * Usage:
+ *   lzss_dec_init(&d, my_fill, ctx);
+ *   n = lzss_decode(&d, out, 128);   // repeat until raw size reached
+ */
+#ifndef OSITO_LZSS_H
+#define OSITO_LZSS_H
+
+#include "osito.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LZSS_WINDOW     256     /* history size (8-bit distance) */
+#define LZSS_MIN_MATCH  2
+#define LZSS_MAX_MATCH  17      /* 4-bit length field */
+#define LZSS_INBUF      32
+
+/* Read up to max compressed bytes into buf. Returns count, 0 at end. */
+typedef uint32_t (*lzss_fill_t)(void *ctx, uint8_t *buf, uint32_t max);
+
+typedef struct {
+    uint8_t     in[LZSS_INBUF] __attribute__((aligned(4)));
+    uint8_t     win[LZSS_WINDOW];
+    lzss_fill_t fill;
+    void       *ctx;
+    uint32_t    bits;           /* bit accumulator, nbits valid low bits */
+    uint8_t     nbits;
+    uint8_t     wpos;           /* next window slot (wraps at 256) */
+    uint8_t     in_pos;
+    uint8_t     in_len;
+    uint16_t    copy_dist;      /* pending back-reference */
+    uint8_t     copy_len;
+    uint8_t     eof;
+} lzss_dec_t;
+
+/* Start decoding a new stream */
+void lzss_dec_init(lzss_dec_t *d, lzss_fill_t fill, void *ctx);
+
+/* Produce up to n bytes. Returns bytes written (< n only if the
+ * compressed input ran out). */
+uint32_t lzss_decode(lzss_dec_t *d, uint8_t *out, uint32_t n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OSITO_LZSS_H */
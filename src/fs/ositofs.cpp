@@ -1,61 +1,150 @@
 /*
- * OsitoFS - Flat filesystem on SPI flash
+ * OsitoFS - Filesystem on SPI flash
  *
- * Contiguous allocation, no directories.
- * All flash operations go through ROM SPI functions.
- * A single 4KB sector buffer is used for read-modify-write cycles.
+ * Contiguous allocation, one optional level of subdirectories.
+ * Reads use the ROM SPIRead (through the read cache); erases and
+ * programs go to the flash I/O task (flashio.h), so the calling task
+ * sleeps instead of spinning while the chip is busy.
+ *
+ * Locking: a reader-writer lock. Lookups and reads (fs_open, fs_fread,
+ * fs_read, fs_stat, fs_readdir, fs_free) share it and run concurrently;
+ * calls that modify the volume take it exclusively. Readers only use
+ * their own stack or handle buffers. The 4KB sector buffer for
+ * read-modify-write cycles belongs to the writer.
+ *
+ * Version 2 keeps metadata updates erase-free where NOR flash allows:
+ * new directory entries and hash buckets are programmed into erased
+ * (0xFF) space, and deletes only clear bits (entry name[0] = 0, bucket
+ * = 0x0000 tombstone). Only in-place changes (size, rename) and reuse
+ * of deleted slots cost a sector erase. The data-sector bitmap is kept
+ * in RAM and rebuilt at mount.
+ *
+ * Small files and the tails of larger ones live in fragment sectors,
+ * split into 16 units of 256 bytes. Which units are in use is rebuilt
+ * from the directory at mount; freed units are not erased until a new
+ * fragment needs them.
  */
 
 #include "fs/ositofs.h"
+#include "fs/fcache.h"
+#include "fs/flashio.h"
 #include "drivers/uart.h"
+#include "mem/heap.h"
+#include "kernel/sem.h"
 #include "kernel/task.h"
 
 extern "C" {
 
-/* Sector buffer for read-modify-write (shared, not reentrant) */
+/* Sector buffer for read-modify-write (writers only, under fs_rw) */
 static uint8_t sec_buf[FS_SECTOR_SIZE] __attribute__((aligned(4)));
 
 /* Mounted flag */
 static int mounted = 0;
 
+/* Shared by readers, exclusive for calls that change the volume
+ * (initialized by fs_init). Not recursive. */
+static rwlock_t fs_rw;
+
+static void fs_lock(void)
+{
+    rwlock_write_lock(&fs_rw);
+}
+
+static void fs_unlock(void)
+{
+    rwlock_write_unlock(&fs_rw);
+}
+
+static void fs_read_lock(void)
+{
+    rwlock_read_lock(&fs_rw);
+}
+
+static void fs_read_unlock(void)
+{
+    rwlock_read_unlock(&fs_rw);
+}
+
+/* Bitmap: 1 bit per data sector, 120 bytes for 958 sectors */
+#define BITMAP_BYTES ((FS_DATA_SECTORS + 7) / 8)
+
+/* Hash bucket encoding: erased = empty, all-zero = deleted (tombstone),
+ * otherwise tag (1..14, 4 bits) << 12 | slot (12 bits). Both transitions
+ * from empty only clear bits, so the index never needs an erase except
+ * when it is rebuilt to drop tombstones. */
+#define HASH_EMPTY      0xFFFF
+#define HASH_DEAD       0x0000
+#define HASH_SLOT(v)    ((v) & 0x0FFF)
+#define HASH_TAG(v)     ((v) >> 12)
+#define HASH_REBUILD_AT (FS_HASH_BUCKETS * 3 / 4)
+
+/* Mounted volume geometry and counters (rebuilt by fs_init) */
+static struct {
+    uint32_t version;
+    uint32_t data_addr;         /* flash address of data sector 0 */
+    uint16_t data_sectors;
+    uint16_t dir_sectors;       /* v2 directory sectors (v1: 1 table) */
+    uint16_t slots;             /* directory capacity in entries */
+    uint16_t hwm;               /* slots at or above this were never used */
+    uint16_t file_count;        /* live entries (files + directories) */
+    uint16_t hash_used;         /* live + tombstoned buckets */
+    int16_t  pending;           /* v1 slot being uploaded (no flags on flash) */
+    uint16_t dir_map[FS_DIR_SECTORS_MAX];
+} vol;
+
+/* Data sectors in use (files + directory sectors + fragment sectors) */
+static uint8_t bmap[BITMAP_BYTES];
+
+/* Fragment sectors and their used 256-byte units (bit n = unit n) */
+static struct {
+    uint16_t sector;
+    uint16_t used;
+} frag_tab[FS_FRAG_SECTORS_MAX];
+static int frag_count = 0;
+
 /* ====== Low-level flash helpers ====== */
 
 static void flash_read(uint32_t addr, void *dst, uint32_t len)
 {
-    /* SPIRead requires 4-byte aligned destination buffer */
-    if (((uint32_t)dst & 3) == 0) {
+    flashio_lock();
+    if (fcache_read(addr, dst, len) == 0) {
+        /* served from the cache */
+    } else if (((addr | (uintptr_t)dst | len) & 3) == 0) {
+        /* SPIRead requires 4-byte aligned address, buffer and length */
         SPIRead(addr, dst, len);
     } else {
         uint8_t tmp[64] __attribute__((aligned(4)));
         uint8_t *p = (uint8_t *)dst;
         while (len > 0) {
-            uint32_t n = len > 64 ? 64 : len;
-            SPIRead(addr, tmp, (n + 3) & ~3u);
-            ets_memcpy(p, tmp, n);
+            uint32_t skip = addr & 3;
+            uint32_t n = len > 60 ? 60 : len;
+            SPIRead(addr - skip, tmp, (skip + n + 3) & ~3u);
+            ets_memcpy(p, tmp + skip, n);
             addr += n;
             p += n;
             len -= n;
         }
     }
+    flashio_unlock();
 }
 
 static void flash_erase_sector(uint32_t addr)
 {
-    SPIEraseSector(addr / FS_SECTOR_SIZE);
+    flashio_erase(addr);
 }
 
 static void flash_write(uint32_t addr, const void *src, uint32_t len)
 {
     /* SPIWrite requires 4-byte aligned source buffer */
-    if (((uint32_t)src & 3) == 0) {
-        SPIWrite(addr, src, len);
+    if (((uintptr_t)src & 3) == 0) {
+        flashio_program(addr, src, len);
     } else {
         uint8_t tmp[64] __attribute__((aligned(4)));
         const uint8_t *p = (const uint8_t *)src;
         while (len > 0) {
             uint32_t n = len > 64 ? 64 : len;
             ets_memcpy(tmp, p, n);
-            SPIWrite(addr, tmp, (n + 3) & ~3u);
+            flashio_program(addr, tmp, (n + 3) & ~3u);
             addr += n;
             p += n;
             len -= n;
@@ -63,6 +152,13 @@ static void flash_write(uint32_t addr, const void *src, uint32_t len)
     }
 }
 
+/* Program one aligned 32-bit word. Only clears bits — no erase. */
+static void flash_program_word(uint32_t addr, uint32_t val)
+{
+    uint32_t w = val;
+    flashio_program(addr, &w, 4);
+}
+
 /* ====== String helpers (avoid ROM dependency issues) ====== */
 
 static int fs_strcmp(const char *a, const char *b)
@@ -78,100 +174,268 @@ static void fs_strncpy(char *dst, const char *src, int n)
     while (i < n) dst[i++] = '\0';
 }
 
-/* ====== File table operations ====== */
+static int fs_strlen(const char *s)
+{
+    int n = 0;
+    while (s[n]) n++;
+    return n;
+}
+
+/* ====== Sector allocation (bitmap-based) ====== */
 
-/* Read full file table into sec_buf */
-static void read_table(void)
+static void bmap_set(int start, int count, int used)
 {
-    flash_read(FS_TABLE_ADDR, sec_buf, FS_SECTOR_SIZE);
+    for (int s = start; s < start + count; s++) {
+        if (s < 0 || s >= (int)vol.data_sectors) continue;
+        if (used)
+            bmap[s / 8] |= (1 << (s % 8));
+        else
+            bmap[s / 8] &= ~(1 << (s % 8));
+    }
 }
 
-/* Write sec_buf back as file table */
-static void write_table(void)
+/* Find N contiguous free sectors. Returns start index or -1. */
+static int alloc_sectors(int count)
 {
-    flash_erase_sector(FS_TABLE_ADDR);
-    flash_write(FS_TABLE_ADDR, sec_buf, FS_SECTOR_SIZE);
+    int run = 0;
+    int start = 0;
+    for (int i = 0; i < (int)vol.data_sectors; i++) {
+        if (bmap[i / 8] & (1 << (i % 8))) {
+            run = 0;
+            start = i + 1;
+        } else {
+            run++;
+            if (run >= count)
+                return start;
+        }
+    }
+    return -1;
 }
 
-/* Get entry pointer within sec_buf (call after read_table) */
-static fs_entry_t *table_entry(int i)
+/* Count free sectors from bitmap */
+static uint32_t count_free(void)
 {
-    return (fs_entry_t *)(sec_buf + i * sizeof(fs_entry_t));
+    uint32_t free = 0;
+    for (int i = 0; i < (int)vol.data_sectors; i++) {
+        if (!(bmap[i / 8] & (1 << (i % 8))))
+            free++;
+    }
+    return free;
 }
 
-/* An entry is unused if name[0] is NUL or 0xFF (erased flash) */
-static int entry_free(fs_entry_t *e)
+static uint32_t data_addr(uint32_t sector)
 {
-    return (e->name[0] == '\0' || (uint8_t)e->name[0] == 0xFF);
+    return vol.data_addr + sector * FS_SECTOR_SIZE;
 }
 
-/* Find entry by name. Returns index or -1. (sec_buf must be loaded) */
-static int find_file(const char *name)
+/*
+ * Write len bytes at addr (within one sector). If the target bytes can
+ * be reached by clearing bits only, they are programmed in place;
+ * otherwise the sector is read-modify-erase-written through sec_buf.
+ * Bytes around the range in the first/last word are reprogrammed with
+ * their current value. src must not point into sec_buf.
+ */
+static void flash_patch(uint32_t addr, const void *src, uint32_t len)
 {
-    for (int i = 0; i < FS_MAX_FILES; i++) {
-        fs_entry_t *e = table_entry(i);
-        if (!entry_free(e) && fs_strcmp(e->name, name) == 0)
-            return i;
+    const uint8_t *p = (const uint8_t *)src;
+    uint32_t a0 = addr & ~3u;
+    uint32_t a1 = (addr + len + 3) & ~3u;
+    uint8_t tmp[64] __attribute__((aligned(4)));
+
+    int ok = 1;
+    for (uint32_t a = a0; a < a1 && ok; a += sizeof(tmp)) {
+        uint32_t n = a1 - a > sizeof(tmp) ? sizeof(tmp) : a1 - a;
+        flash_read(a, tmp, n);
+        for (uint32_t i = 0; i < n; i++) {
+            uint32_t pos = a + i;
+            if (pos < addr || pos >= addr + len) continue;
+            if (p[pos - addr] & ~tmp[i]) { ok = 0; break; }
+        }
     }
-    return -1;
+
+    if (ok) {
+        for (uint32_t a = a0; a < a1; a += sizeof(tmp)) {
+            uint32_t n = a1 - a > sizeof(tmp) ? sizeof(tmp) : a1 - a;
+            flash_read(a, tmp, n);
+            for (uint32_t i = 0; i < n; i++) {
+                uint32_t pos = a + i;
+                if (pos >= addr && pos < addr + len)
+                    tmp[i] = p[pos - addr];
+            }
+            flash_write(a, tmp, n);
+        }
+        return;
+    }
+
+    uint32_t sec = addr & ~(uint32_t)(FS_SECTOR_SIZE - 1);
+    flash_read(sec, sec_buf, FS_SECTOR_SIZE);
+    ets_memcpy(sec_buf + (addr - sec), p, len);
+    flash_erase_sector(sec);
+    flash_write(sec, sec_buf, FS_SECTOR_SIZE);
 }
 
-/* Find first unused slot. Returns index or -1. */
-static int find_free_slot(void)
+/* Write file data into a freshly erased area, padding the last word with
+ * 0xFF so a later append can program the rest without an erase. */
+static void flash_write_padded(uint32_t addr, const void *src, uint32_t len)
 {
-    for (int i = 0; i < FS_MAX_FILES; i++) {
-        if (entry_free(table_entry(i)))
-            return i;
+    uint32_t whole = len & ~3u;
+    if (whole)
+        flash_write(addr, src, whole);
+    if (len > whole) {
+        uint32_t w = 0xFFFFFFFF;
+        ets_memcpy(&w, (const uint8_t *)src + whole, len - whole);
+        flash_program_word(addr + whole, w);
     }
+}
+
+/* ====== Fragments (v2) ====== */
+
+static int frag_find(uint16_t sector)
+{
+    for (int i = 0; i < frag_count; i++)
+        if (frag_tab[i].sector == sector) return i;
     return -1;
 }
 
-/* ====== Sector allocation (bitmap-based) ====== */
+static uint16_t frag_mask(int unit, int units)
+{
+    return (uint16_t)(((1u << units) - 1) << unit);
+}
 
-/* Bitmap: 1 bit per data sector, 120 bytes for 958 sectors */
-#define BITMAP_BYTES ((FS_DATA_SECTORS + 7) / 8)
+/* Units are erased 0xFF? Freed units keep their old data until reused. */
+static int frag_units_erased(uint16_t sector, int unit, int units)
+{
+    uint32_t w[16];
+    uint32_t addr = data_addr(sector) + (uint32_t)unit * FS_FRAG_UNIT;
+    uint32_t end = addr + (uint32_t)units * FS_FRAG_UNIT;
+    for (; addr < end; addr += sizeof(w)) {
+        flash_read(addr, w, sizeof(w));
+        for (int i = 0; i < 16; i++)
+            if (w[i] != 0xFFFFFFFF) return 0;
+    }
+    return 1;
+}
 
-static void build_bitmap(uint8_t *bmap)
+/*
+ * Make units [unit, unit+units) of fragment sector fi erased before they
+ * are handed out. Dirty units force one sector rewrite that keeps only
+ * live units, which also cleans every other freed unit in the sector.
+ */
+static void frag_prepare(int fi, int unit, int units)
 {
-    ets_memset(bmap, 0, BITMAP_BYTES);
-    for (int i = 0; i < FS_MAX_FILES; i++) {
-        fs_entry_t *e = table_entry(i);
-        if (entry_free(e)) continue;
-        for (int s = 0; s < e->sector_count; s++) {
-            int bit = e->start_sector + s;
-            if (bit < (int)FS_DATA_SECTORS)
-                bmap[bit / 8] |= (1 << (bit % 8));
-        }
+    uint16_t sector = frag_tab[fi].sector;
+    if (frag_units_erased(sector, unit, units))
+        return;
+
+    uint32_t addr = data_addr(sector);
+    flash_read(addr, sec_buf, FS_SECTOR_SIZE);
+    for (int u = 0; u < FS_FRAG_PER_SECTOR; u++) {
+        if (!(frag_tab[fi].used & (1u << u)))
+            ets_memset(sec_buf + u * FS_FRAG_UNIT, 0xFF, FS_FRAG_UNIT);
     }
+    flash_erase_sector(addr);
+    flash_write(addr, sec_buf, FS_SECTOR_SIZE);
 }
 
-/* Find N contiguous free sectors. Returns start index or -1. */
-static int alloc_sectors(uint8_t *bmap, int count)
+/*
+ * Allocate units contiguous 256-byte units, first fit over the existing
+ * fragment sectors, else a new sector. Fills the entry's frag fields.
+ * Returns 0, or -1 if no space.
+ */
+static int frag_alloc(int units, fs_dirent_t *e)
 {
-    int run = 0;
-    int start = 0;
-    for (int i = 0; i < (int)FS_DATA_SECTORS; i++) {
-        if (bmap[i / 8] & (1 << (i % 8))) {
-            run = 0;
-            start = i + 1;
-        } else {
-            run++;
-            if (run >= count)
-                return start;
+    for (int i = 0; i < frag_count; i++) {
+        for (int u = 0; u + units <= FS_FRAG_PER_SECTOR; u++) {
+            uint16_t m = frag_mask(u, units);
+            if (frag_tab[i].used & m) continue;
+            frag_prepare(i, u, units);
+            frag_tab[i].used |= m;
+            e->frag_sector = frag_tab[i].sector;
+            e->frag_unit = (uint8_t)u;
+            e->frag_units = (uint8_t)units;
+            return 0;
         }
     }
-    return -1;
+
+    if (frag_count >= FS_FRAG_SECTORS_MAX)
+        return -1;
+    int s = alloc_sectors(1);
+    if (s < 0)
+        return -1;
+
+    flash_erase_sector(data_addr((uint32_t)s));
+    bmap_set(s, 1, 1);
+    frag_tab[frag_count].sector = (uint16_t)s;
+    frag_tab[frag_count].used = frag_mask(0, units);
+    frag_count++;
+    e->frag_sector = (uint16_t)s;
+    e->frag_unit = 0;
+    e->frag_units = (uint8_t)units;
+    return 0;
 }
 
-/* Count free sectors from bitmap */
-static uint32_t count_free(uint8_t *bmap)
+/* Release a fragment; a sector with no units left goes back to the pool */
+static void frag_free(uint16_t sector, int unit, int units)
 {
-    uint32_t free = 0;
-    for (int i = 0; i < (int)FS_DATA_SECTORS; i++) {
-        if (!(bmap[i / 8] & (1 << (i % 8))))
-            free++;
+    int i = frag_find(sector);
+    if (i < 0) return;
+    frag_tab[i].used &= (uint16_t)~frag_mask(unit, units);
+    if (frag_tab[i].used == 0) {
+        bmap_set(sector, 1, 0);
+        frag_tab[i] = frag_tab[--frag_count];
+    }
+}
+
+/* Free bytes in fragment sectors */
+static uint32_t frag_free_bytes(void)
+{
+    uint32_t units = 0;
+    for (int i = 0; i < frag_count; i++) {
+        for (int u = 0; u < FS_FRAG_PER_SECTOR; u++)
+            if (!(frag_tab[i].used & (1u << u))) units++;
+    }
+    return units * FS_FRAG_UNIT;
+}
+
+static int has_frag(const fs_dirent_t *e)
+{
+    return e->frag_units != 0 && e->frag_units != 0xFF;
+}
+
+static uint32_t frag_addr(const fs_dirent_t *e)
+{
+    return data_addr(e->frag_sector) + (uint32_t)e->frag_unit * FS_FRAG_UNIT;
+}
+
+/* Units for the tail of a file of this size, or 0 to use full sectors */
+static int tail_units(uint32_t size)
+{
+    if (vol.version != 2) return 0;
+    uint32_t tail = size % FS_SECTOR_SIZE;
+    if (tail == 0) return 0;
+    int units = (int)((tail + FS_FRAG_UNIT - 1) / FS_FRAG_UNIT);
+    return units <= FS_FRAG_MAX_UNITS ? units : 0;
+}
+
+/* Write file bytes [pos, pos+len) into the entry's sectors and fragment */
+static void file_write(const fs_dirent_t *e, uint32_t pos, const uint8_t *src, uint32_t len)
+{
+    uint32_t full = (uint32_t)e->sector_count * FS_SECTOR_SIZE;
+    while (len > 0) {
+        uint32_t addr, room;
+        if (pos < full) {
+            addr = data_addr(e->start_sector + pos / FS_SECTOR_SIZE) + pos % FS_SECTOR_SIZE;
+            room = FS_SECTOR_SIZE - pos % FS_SECTOR_SIZE;
+        } else {
+            addr = frag_addr(e) + (pos - full);
+            room = (uint32_t)e->frag_units * FS_FRAG_UNIT - (pos - full);
+        }
+        uint32_t n = len < room ? len : room;
+        flash_patch(addr, src, n);
+        pos += n;
+        src += n;
+        len -= n;
     }
-    return free;
 }
 
 /* ====== Superblock ====== */
@@ -190,24 +454,633 @@ static void write_super(fs_super_t *sb)
     flash_write(FS_SUPER_ADDR, sec_buf, FS_SECTOR_SIZE);
 }
 
+/* Superblock for the current v2 geometry */
+static void write_super_v2(void)
+{
+    fs_super_t sb;
+    ets_memset(&sb, 0xFF, sizeof(sb));
+    sb.magic = FS_MAGIC;
+    sb.version = 2;
+    sb.total_sectors = vol.data_sectors;
+    sb.file_count = 0;
+    sb.data_start = (uint16_t)((vol.data_addr - FS_FLASH_BASE) / FS_SECTOR_SIZE);
+    sb.hash_sectors = FS_HASH_SECTORS;
+    sb.dir_sectors = vol.dir_sectors;
+    sb.dir_per_sector = FS_DIR_PER_SECTOR;
+    for (int i = 0; i < vol.dir_sectors; i++)
+        sb.dir_map[i] = vol.dir_map[i];
+    write_super(&sb);
+}
+
+/* Version 1 keeps its file count in the superblock */
+static void v1_adjust_count(int delta)
+{
+    if (vol.version != 1) return;
+    fs_super_t sb;
+    read_super(&sb);
+    if (delta < 0 && sb.file_count > 0) sb.file_count--;
+    if (delta > 0) sb.file_count++;
+    write_super(&sb);
+}
+
+/* ====== Directory entries ====== */
+
+/* An entry is unused if name[0] is NUL or 0xFF (erased flash) */
+static int entry_free(const fs_dirent_t *e)
+{
+    return (e->name[0] == '\0' || (uint8_t)e->name[0] == 0xFF);
+}
+
+static uint32_t slot_addr(int slot)
+{
+    if (vol.version == 1)
+        return FS_TABLE_ADDR + (uint32_t)slot * sizeof(fs_entry_t);
+    return data_addr(vol.dir_map[slot / FS_DIR_PER_SECTOR])
+         + (uint32_t)(slot % FS_DIR_PER_SECTOR) * sizeof(fs_dirent_t);
+}
+
+static void v1_to_dirent(const fs_entry_t *e, fs_dirent_t *d)
+{
+    ets_memset(d, 0xFF, sizeof(*d));
+    ets_memcpy(d->name, e->name, FS_NAME_LEN);
+    d->size = e->size;
+    d->start_sector = e->start_sector;
+    d->sector_count = e->sector_count;
+    d->parent = FS_ROOT;
+    d->type = FS_TYPE_FILE;
+    d->flags = 0;
+}
+
+static void dirent_to_v1(const fs_dirent_t *d, fs_entry_t *e)
+{
+    ets_memcpy(e->name, d->name, FS_NAME_LEN);
+    e->size = d->size;
+    e->start_sector = d->start_sector;
+    e->sector_count = d->sector_count;
+}
+
+static void read_entry(int slot, fs_dirent_t *d)
+{
+    if (vol.version == 1) {
+        fs_entry_t e __attribute__((aligned(4)));
+        flash_read(slot_addr(slot), &e, sizeof(e));
+        v1_to_dirent(&e, d);
+        if (slot == vol.pending)
+            d->flags = FS_F_PENDING;
+    } else {
+        flash_read(slot_addr(slot), d, sizeof(*d));
+    }
+}
+
+/*
+ * Rewrite one entry in place: read-modify-erase-write of its sector.
+ * d == NULL clears the slot. In v2 sectors, deleted slots are turned
+ * back into erased ones on the way, so they can be reused erase-free.
+ */
+static void rewrite_entry(int slot, const fs_dirent_t *d)
+{
+    uint32_t addr = slot_addr(slot);
+    uint32_t sec = addr & ~(uint32_t)(FS_SECTOR_SIZE - 1);
+    uint32_t off = addr - sec;
+
+    flash_read(sec, sec_buf, FS_SECTOR_SIZE);
+
+    if (vol.version == 1) {
+        fs_entry_t *e = (fs_entry_t *)(sec_buf + off);
+        if (d)
+            dirent_to_v1(d, e);
+        else
+            ets_memset(e, 0, sizeof(fs_entry_t));
+    } else {
+        for (uint32_t o = 0; o < FS_SECTOR_SIZE; o += sizeof(fs_dirent_t)) {
+            if (sec_buf[o] == '\0')
+                ets_memset(sec_buf + o, 0xFF, sizeof(fs_dirent_t));
+        }
+        if (d)
+            ets_memcpy(sec_buf + off, d, sizeof(fs_dirent_t));
+        else
+            ets_memset(sec_buf + off, 0xFF, sizeof(fs_dirent_t));
+    }
+
+    flash_erase_sector(sec);
+    flash_write(sec, sec_buf, FS_SECTOR_SIZE);
+}
+
+/* Store a new entry: program into an erased v2 slot, else rewrite */
+static void store_entry(int slot, const fs_dirent_t *d)
+{
+    if (vol.version == 2) {
+        uint32_t head;
+        flash_read(slot_addr(slot), &head, 4);
+        if ((head & 0xFF) == 0xFF) {
+            flash_write(slot_addr(slot), d, sizeof(fs_dirent_t));
+            return;
+        }
+    }
+    rewrite_entry(slot, d);
+}
+
+/* Mark an entry deleted: v2 clears the first name word (program only) */
+static void kill_entry(int slot)
+{
+    if (vol.version == 2)
+        flash_program_word(slot_addr(slot), 0);
+    else
+        rewrite_entry(slot, nullptr);
+}
+
+/* Add a directory sector (v2). Returns 0 on success. */
+static int grow_dir(void)
+{
+    if (vol.version != 2 || vol.dir_sectors >= FS_DIR_SECTORS_MAX)
+        return -1;
+    int s = alloc_sectors(1);
+    if (s < 0)
+        return -1;
+
+    flash_erase_sector(data_addr((uint32_t)s));
+    bmap_set(s, 1, 1);
+    vol.dir_map[vol.dir_sectors++] = (uint16_t)s;
+    vol.slots = (uint16_t)(vol.dir_sectors * FS_DIR_PER_SECTOR);
+    write_super_v2();
+    return 0;
+}
+
+/* Find a slot for a new entry. Prefers never-used slots (no erase). */
+static int find_free_slot(void)
+{
+    if (vol.hwm >= vol.slots)
+        grow_dir();
+    if (vol.hwm < vol.slots)
+        return vol.hwm;
+
+    /* Directory at full size: reuse a deleted slot */
+    for (int i = 0; i < vol.slots; i++) {
+        uint32_t head;
+        flash_read(slot_addr(i), &head, 4);
+        uint8_t c = (uint8_t)(head & 0xFF);
+        if (c == 0 || c == 0xFF)
+            return i;
+    }
+    return -1;
+}
+
+/* ====== Hash index (v2) ====== */
+
+/* FNV-1a over parent slot and name */
+static uint32_t name_hash(uint16_t parent, const char *name)
+{
+    uint32_t h = 2166136261u;
+    h = (h ^ (parent & 0xFF)) * 16777619u;
+    h = (h ^ (parent >> 8)) * 16777619u;
+    while (*name)
+        h = (h ^ (uint8_t)*name++) * 16777619u;
+    return h;
+}
+
+static uint16_t hash_tag(uint32_t h)
+{
+    return (uint16_t)((h >> 16) % 14 + 1);
+}
+
+static void hash_set(int bucket, uint16_t v)
+{
+    uint32_t addr = FS_HASH_ADDR + (uint32_t)bucket * 2;
+    uint32_t w;
+    flash_read(addr & ~3u, &w, 4);
+    if (bucket & 1)
+        w = (w & 0x0000FFFF) | ((uint32_t)v << 16);
+    else
+        w = (w & 0xFFFF0000) | v;
+    flash_program_word(addr & ~3u, w);
+}
+
+/*
+ * Probe for (parent, name). Returns the slot and fills *d, or -1.
+ * *bucket receives the matching bucket, or the first empty bucket when
+ * not found (-1 if the index is full). Buckets are fetched 8 at a time,
+ * so a lookup is typically two flash reads: one bucket group, one entry.
+ */
+static int hash_lookup(uint16_t parent, const char *name, uint32_t h,
+                       int *bucket, fs_dirent_t *d)
+{
+    uint16_t grp[8] __attribute__((aligned(4)));
+    int loaded = -1;
+    uint16_t tag = hash_tag(h);
+
+    for (int i = 0; i < FS_HASH_BUCKETS; i++) {
+        int b = (int)((h + (uint32_t)i) & (FS_HASH_BUCKETS - 1));
+        if ((b & ~7) != loaded) {
+            loaded = b & ~7;
+            flash_read(FS_HASH_ADDR + (uint32_t)loaded * 2, grp, sizeof(grp));
+        }
+        uint16_t v = grp[b & 7];
+        if (v == HASH_EMPTY) {
+            *bucket = b;
+            return -1;
+        }
+        if (v == HASH_DEAD || HASH_TAG(v) != tag)
+            continue;
+
+        int slot = HASH_SLOT(v);
+        read_entry(slot, d);
+        if (!entry_free(d) && d->parent == parent && fs_strcmp(d->name, name) == 0) {
+            *bucket = b;
+            return slot;
+        }
+    }
+    *bucket = -1;
+    return -1;
+}
+
+/* First bucket on h's probe chain holding want (HASH_EMPTY: first free) */
+static int hash_probe(uint32_t h, uint16_t want)
+{
+    uint16_t grp[8] __attribute__((aligned(4)));
+    int loaded = -1;
+
+    for (int i = 0; i < FS_HASH_BUCKETS; i++) {
+        int b = (int)((h + (uint32_t)i) & (FS_HASH_BUCKETS - 1));
+        if ((b & ~7) != loaded) {
+            loaded = b & ~7;
+            flash_read(FS_HASH_ADDR + (uint32_t)loaded * 2, grp, sizeof(grp));
+        }
+        if (grp[b & 7] == want) return b;
+        if (grp[b & 7] == HASH_EMPTY) break;
+    }
+    return -1;
+}
+
+static uint16_t hash_value(uint32_t h, int slot)
+{
+    return (uint16_t)((hash_tag(h) << 12) | slot);
+}
+
+static void hash_rebuild(void);
+
+/*
+ * Insert slot into the index. bucket may carry a known-empty bucket.
+ * The entry must already be stored in the table: a rebuild re-indexes
+ * it along with every other live slot, and nothing is left to insert.
+ */
+static void hash_insert(uint32_t h, int slot, int bucket)
+{
+    if (vol.hash_used + 1 >= HASH_REBUILD_AT) {
+        hash_rebuild();
+        return;
+    }
+
+    if (bucket < 0)
+        bucket = hash_probe(h, HASH_EMPTY);
+    if (bucket < 0)
+        return;
+    hash_set(bucket, hash_value(h, slot));
+    vol.hash_used++;
+}
+
+static void hash_remove(uint32_t h, int slot)
+{
+    int b = hash_probe(h, hash_value(h, slot));
+    if (b >= 0)
+        hash_set(b, HASH_DEAD);
+}
+
+/* Erase the index and re-insert every live entry (drops tombstones) */
+static void hash_rebuild(void)
+{
+    for (int s = 0; s < FS_HASH_SECTORS; s++)
+        flash_erase_sector(FS_HASH_ADDR + (uint32_t)s * FS_SECTOR_SIZE);
+    vol.hash_used = 0;
+
+    fs_dirent_t d;
+    for (int i = 0; i < vol.hwm; i++) {
+        read_entry(i, &d);
+        if (entry_free(&d)) continue;
+        int b = hash_probe(d.hash, HASH_EMPTY);
+        if (b < 0) break;
+        hash_set(b, hash_value(d.hash, i));
+        vol.hash_used++;
+    }
+}
+
+/* ====== Name lookup ====== */
+
+/* Find entry by (parent, name). Returns slot or -1. *bucket as hash_lookup. */
+static int find_entry(uint16_t parent, const char *name, fs_dirent_t *d, int *bucket)
+{
+    *bucket = -1;
+    if (vol.version == 2)
+        return hash_lookup(parent, name, name_hash(parent, name), bucket, d);
+
+    /* Version 1: linear scan of the table, one entry at a time (the
+     * read cache turns this into a few page reads) */
+    if (parent != FS_ROOT) return -1;
+    for (int i = 0; i < FS_V1_MAX_FILES; i++) {
+        read_entry(i, d);
+        if (entry_free(d)) continue;
+        if (fs_strcmp(d->name, name) == 0)
+            return i;
+    }
+    return -1;
+}
+
+/*
+ * Split "dir/name" into parent slot and leaf name. Top-level names get
+ * FS_ROOT. Returns 0, or -1 if the directory is missing or the path is
+ * malformed (more than one level, empty or over-long component).
+ */
+static int split_path(const char *path, uint16_t *parent, char *leaf)
+{
+    if (*path == '/') path++;
+
+    const char *slash = path;
+    while (*slash && *slash != '/') slash++;
+
+    *parent = FS_ROOT;
+    if (*slash == '/') {
+        int dlen = (int)(slash - path);
+        if (dlen == 0 || dlen >= FS_NAME_LEN || vol.version != 2)
+            return -1;
+
+        char dname[FS_NAME_LEN];
+        for (int i = 0; i < dlen; i++) dname[i] = path[i];
+        dname[dlen] = '\0';
+
+        fs_dirent_t d;
+        int b;
+        int ds = find_entry(FS_ROOT, dname, &d, &b);
+        if (ds < 0 || d.type != FS_TYPE_DIR)
+            return -1;
+        *parent = (uint16_t)ds;
+        path = slash + 1;
+    }
+
+    int len = fs_strlen(path);
+    if (len == 0 || len >= FS_NAME_LEN)
+        return -1;
+    for (int i = 0; i < len; i++)
+        if (path[i] == '/') return -1;
+
+    fs_strncpy(leaf, path, FS_NAME_LEN);
+    return 0;
+}
+
+/* Resolve a path to a slot. Returns slot or -1. Uploads in progress
+ * are not found; find_entry still sees them, so their name stays taken. */
+static int lookup(const char *path, fs_dirent_t *d, int *bucket)
+{
+    uint16_t parent;
+    char leaf[FS_NAME_LEN];
+    if (split_path(path, &parent, leaf) < 0)
+        return -1;
+    int slot = find_entry(parent, leaf, d, bucket);
+    if (slot >= 0 && (d->flags & FS_F_PENDING))
+        return -1;
+    return slot;
+}
+
+/* Add a new entry (slot allocation, index insert). Returns slot or -1. */
+static int add_entry(fs_dirent_t *d, int bucket)
+{
+    int slot = find_free_slot();
+    if (slot < 0)
+        return -1;
+
+    store_entry(slot, d);
+    if (slot >= vol.hwm)
+        vol.hwm = (uint16_t)(slot + 1);
+    if (vol.version == 2)
+        hash_insert(d->hash, slot, bucket);
+    vol.file_count++;
+    return slot;
+}
+
+/* Remove an entry and release its data sectors */
+static void remove_entry(int slot, const fs_dirent_t *d)
+{
+    kill_entry(slot);
+    if (vol.version == 2)
+        hash_remove(d->hash, slot);
+    if (d->type == FS_TYPE_FILE) {
+        bmap_set(d->start_sector, d->sector_count, 0);
+        if (has_frag(d))
+            frag_free(d->frag_sector, d->frag_unit, d->frag_units);
+    }
+    if (vol.file_count > 0)
+        vol.file_count--;
+}
+
+static void init_dirent(fs_dirent_t *d, uint16_t parent, const char *leaf, uint8_t type)
+{
+    ets_memset(d, 0xFF, sizeof(*d));
+    fs_strncpy(d->name, leaf, FS_NAME_LEN);
+    d->size = 0;
+    d->start_sector = 0;
+    d->sector_count = 0;
+    d->parent = parent;
+    d->type = type;
+    d->flags = 0;
+    d->hash = name_hash(parent, leaf);
+}
+
+/* Are data sectors [start, start+count) all free? */
+static int sectors_free(int start, int count)
+{
+    if (start + count > (int)vol.data_sectors) return 0;
+    for (int s = start; s < start + count; s++)
+        if (bmap[s / 8] & (1 << (s % 8))) return 0;
+    return 1;
+}
+
+/*
+ * Re-lay out a file to hold new_size bytes: extend the tail fragment in
+ * place, or move the tail to a new fragment, and extend the sector run
+ * in place or copy it to a new run. Existing bytes are preserved; the
+ * caller writes the new ones. Updates *e. Returns 0, or -1 if no space
+ * (nothing changed).
+ */
+static int grow_file(fs_dirent_t *e, uint32_t new_size)
+{
+    uint32_t full = (uint32_t)e->sector_count * FS_SECTOR_SIZE;
+    int units = tail_units(new_size);
+    uint16_t nsec = (uint16_t)(new_size / FS_SECTOR_SIZE);
+
+    /* Same sector run, bigger tail: take the units after the fragment */
+    if (units && nsec == e->sector_count && has_frag(e) &&
+        e->frag_unit + units <= FS_FRAG_PER_SECTOR) {
+        int fi = frag_find(e->frag_sector);
+        int first = e->frag_unit + e->frag_units;
+        uint16_t extra = frag_mask(first, units - e->frag_units);
+        if (fi >= 0 && !(frag_tab[fi].used & extra)) {
+            frag_prepare(fi, first, units - e->frag_units);
+            frag_tab[fi].used |= extra;
+            e->frag_units = (uint8_t)units;
+            return 0;
+        }
+    }
+
+    fs_dirent_t n = *e;
+    n.frag_sector = 0xFFFF;
+    n.frag_unit = 0xFF;
+    n.frag_units = 0xFF;
+    if (units && frag_alloc(units, &n) < 0)
+        units = 0;
+    if (!units)
+        nsec = (uint16_t)((new_size + FS_SECTOR_SIZE - 1) / FS_SECTOR_SIZE);
+
+    if (nsec > e->sector_count) {
+        int start = -1;
+        if (e->sector_count &&
+            sectors_free(e->start_sector + e->sector_count, nsec - e->sector_count))
+            start = e->start_sector;
+        else
+            start = alloc_sectors(nsec);
+        if (start < 0) {
+            if (units)
+                frag_free(n.frag_sector, n.frag_unit, n.frag_units);
+            return -1;
+        }
+
+        for (int s = 0; s < nsec; s++) {
+            if (start == e->start_sector && s < e->sector_count)
+                continue;
+            uint32_t dst = data_addr((uint32_t)(start + s));
+            if (s < e->sector_count)
+                flash_read(data_addr((uint32_t)(e->start_sector + s)), sec_buf, FS_SECTOR_SIZE);
+            flash_erase_sector(dst);
+            if (s < e->sector_count)
+                flash_write(dst, sec_buf, FS_SECTOR_SIZE);
+        }
+        if (start != e->start_sector)
+            bmap_set(e->start_sector, e->sector_count, 0);
+        bmap_set(start, nsec, 1);
+        n.start_sector = (uint16_t)start;
+        n.sector_count = nsec;
+    }
+
+    /* Move the old tail [full, size) into the new layout */
+    if (has_frag(e)) {
+        uint8_t tmp[64] __attribute__((aligned(4)));
+        uint32_t tail = e->size - full;
+        for (uint32_t off = 0; off < tail; off += sizeof(tmp)) {
+            uint32_t len = tail - off > sizeof(tmp) ? sizeof(tmp) : tail - off;
+            flash_read(frag_addr(e) + off, tmp, len);
+            file_write(&n, full + off, tmp, len);
+        }
+        frag_free(e->frag_sector, e->frag_unit, e->frag_units);
+    }
+
+    *e = n;
+    return 0;
+}
+
+/* ====== Mount ====== */
+
+/* Scan the directory: live count, high-water mark, sector bitmap */
+static void scan_volume(void)
+{
+    ets_memset(bmap, 0, BITMAP_BYTES);
+    frag_count = 0;
+    vol.file_count = 0;
+    vol.hwm = 0;
+    vol.pending = -1;
+
+    for (int i = 0; i < vol.dir_sectors; i++) {
+        if (vol.version == 2)
+            bmap_set(vol.dir_map[i], 1, 1);
+    }
+
+    fs_dirent_t d;
+    for (int i = 0; i < vol.slots; i++) {
+        read_entry(i, &d);
+        if ((uint8_t)d.name[0] != 0xFF)
+            vol.hwm = (uint16_t)(i + 1);
+        if (entry_free(&d)) continue;
+        if (d.flags & FS_F_PENDING) {
+            /* Upload cut short by a reset: its data never arrived */
+            kill_entry(i);
+            hash_remove(d.hash, i);
+            continue;
+        }
+        vol.file_count++;
+        if (d.type != FS_TYPE_FILE) continue;
+        bmap_set(d.start_sector, d.sector_count, 1);
+        if (has_frag(&d)) {
+            int fi = frag_find(d.frag_sector);
+            if (fi < 0 && frag_count < FS_FRAG_SECTORS_MAX) {
+                fi = frag_count++;
+                frag_tab[fi].sector = d.frag_sector;
+                frag_tab[fi].used = 0;
+            }
+            if (fi >= 0)
+                frag_tab[fi].used |= frag_mask(d.frag_unit, d.frag_units);
+            bmap_set(d.frag_sector, 1, 1);
+        }
+    }
+
+    /* Version 1 tables were zero-filled: treat every free slot as reusable */
+    if (vol.version == 1)
+        vol.hwm = vol.slots;
+
+    vol.hash_used = 0;
+    if (vol.version == 2) {
+        for (int s = 0; s < FS_HASH_SECTORS; s++) {
+            flash_read(FS_HASH_ADDR + (uint32_t)s * FS_SECTOR_SIZE, sec_buf, FS_SECTOR_SIZE);
+            const uint16_t *b = (const uint16_t *)sec_buf;
+            for (int i = 0; i < FS_SECTOR_SIZE / 2; i++)
+                if (b[i] != HASH_EMPTY) vol.hash_used++;
+        }
+    }
+}
+
 /* ====== Public API ====== */
 
 int fs_init(void)
 {
     fs_super_t sb;
+    rwlock_init(&fs_rw);
+    flashio_lock();
+    fcache_invalidate_all();
+    flashio_unlock();
     read_super(&sb);
 
-    if (sb.magic != FS_MAGIC || sb.version != FS_VERSION) {
+    mounted = 0;
+    if (sb.magic != FS_MAGIC || (sb.version != 1 && sb.version != 2)) {
         uart_puts("fs: no filesystem found (use 'fs format')\n");
-        mounted = 0;
         return -1;
     }
 
+    vol.version = sb.version;
+    if (sb.version == 1) {
+        vol.data_addr = FS_DATA_ADDR;
+        vol.data_sectors = FS_DATA_SECTORS;
+        vol.dir_sectors = 1;
+        vol.slots = FS_V1_MAX_FILES;
+    } else {
+        if (sb.dir_sectors == 0 || sb.dir_sectors > FS_DIR_SECTORS_MAX ||
+            sb.dir_per_sector != FS_DIR_PER_SECTOR ||
+            sb.hash_sectors != FS_HASH_SECTORS ||
+            sb.total_sectors > FS_DATA_SECTORS) {
+            uart_puts("fs: unsupported v2 geometry\n");
+            return -1;
+        }
+        vol.data_addr = FS_FLASH_BASE + (uint32_t)sb.data_start * FS_SECTOR_SIZE;
+        vol.data_sectors = (uint16_t)sb.total_sectors;
+        vol.dir_sectors = sb.dir_sectors;
+        vol.slots = (uint16_t)(sb.dir_sectors * FS_DIR_PER_SECTOR);
+        for (int i = 0; i < sb.dir_sectors; i++)
+            vol.dir_map[i] = sb.dir_map[i];
+    }
+
+    scan_volume();
     mounted = 1;
-    uart_puts("fs: mounted, ");
-    uart_put_dec(sb.file_count);
+
+    uart_puts("fs: mounted v");
+    uart_put_dec(vol.version);
+    uart_puts(", ");
+    uart_put_dec(vol.file_count);
     uart_puts(" files, ");
-    uart_put_dec(sb.total_sectors);
+    uart_put_dec(vol.data_sectors);
     uart_puts(" sectors\n");
     return 0;
 }
@@ -216,66 +1089,88 @@ int fs_format(void)
 {
     uart_puts("fs: formatting...\n");
 
-    /* Erase superblock and file table sectors */
-    flash_erase_sector(FS_SUPER_ADDR);
-    flash_erase_sector(FS_TABLE_ADDR);
+    fs_lock();
+    flashio_lock();
+    fcache_invalidate_all();
+    flashio_unlock();
 
-    /* Zero-fill file table (erased flash = 0xFF, we need 0x00) */
-    ets_memset(sec_buf, 0, FS_SECTOR_SIZE);
-    flash_write(FS_TABLE_ADDR, sec_buf, FS_SECTOR_SIZE);
+    /* Erase superblock and hash index (erased = all buckets empty) */
+    flash_erase_sector(FS_SUPER_ADDR);
+    for (int s = 0; s < FS_HASH_SECTORS; s++)
+        flash_erase_sector(FS_HASH_ADDR + (uint32_t)s * FS_SECTOR_SIZE);
+
+    vol.version = 2;
+    vol.data_addr = FS_V2_DATA_ADDR;
+    vol.data_sectors = (uint16_t)((FS_FLASH_END - FS_V2_DATA_ADDR) / FS_SECTOR_SIZE);
+    vol.dir_sectors = 0;
+    vol.slots = 0;
+    vol.hwm = 0;
+    vol.file_count = 0;
+    vol.hash_used = 0;
+    ets_memset(bmap, 0, BITMAP_BYTES);
+    frag_count = 0;
 
-    /* Write superblock */
-    fs_super_t sb;
-    ets_memset(&sb, 0, sizeof(sb));
-    sb.magic = FS_MAGIC;
-    sb.version = FS_VERSION;
-    sb.total_sectors = FS_DATA_SECTORS;
-    sb.file_count = 0;
-    write_super(&sb);
+    /* First directory sector; also writes the superblock */
+    grow_dir();
 
+    fs_unlock();
     mounted = 1;
 
     uart_puts("fs: formatted, ");
-    uart_put_dec(FS_DATA_SECTORS);
+    uart_put_dec(vol.data_sectors);
     uart_puts(" sectors (");
-    uart_put_dec(FS_DATA_SECTORS * FS_SECTOR_SIZE / 1024);
+    uart_put_dec(vol.data_sectors * FS_SECTOR_SIZE / 1024);
     uart_puts(" KB) available\n");
     return 0;
 }
 
-int fs_create(const char *name, const void *data, uint32_t size)
+static int create_file(const char *name, const void *data, uint32_t size,
+                       uint8_t flags, uint32_t raw_size)
 {
     if (!mounted) return -1;
     if (name[0] == '\0' || size == 0) return -1;
 
-    uint32_t ps = irq_save();
-    read_table();
+    fs_lock();
+
+    uint16_t parent;
+    char leaf[FS_NAME_LEN];
+    if (split_path(name, &parent, leaf) < 0) {
+        fs_unlock();
+        uart_puts("fs: bad path\n");
+        return -1;
+    }
 
     /* Check if file already exists */
-    if (find_file(name) >= 0) {
-        irq_restore(ps);
+    fs_dirent_t e;
+    int bucket;
+    if (find_entry(parent, leaf, &e, &bucket) >= 0) {
+        fs_unlock();
         uart_puts("fs: file exists\n");
         return -1;
     }
 
-    /* Find free slot */
-    int slot = find_free_slot();
-    if (slot < 0) {
-        irq_restore(ps);
+    if (vol.file_count >= vol.slots && vol.dir_sectors >= FS_DIR_SECTORS_MAX) {
+        fs_unlock();
         uart_puts("fs: file table full\n");
         return -1;
     }
 
-    /* Calculate sectors needed */
-    uint16_t nsec = (uint16_t)((size + FS_SECTOR_SIZE - 1) / FS_SECTOR_SIZE);
-
-    /* Build bitmap and allocate */
-    uint8_t bmap[BITMAP_BYTES];
-    build_bitmap(bmap);
-
-    int start = alloc_sectors(bmap, nsec);
+    init_dirent(&e, parent, leaf, FS_TYPE_FILE);
+    e.size = size;
+    e.flags = flags;
+    e.raw_size = raw_size;
+
+    /* Small tail goes into a shared fragment, the rest in full sectors */
+    int units = tail_units(size);
+    if (units && frag_alloc(units, &e) < 0)
+        units = 0;
+    uint16_t nsec = (uint16_t)(units ? size / FS_SECTOR_SIZE
+                                     : (size + FS_SECTOR_SIZE - 1) / FS_SECTOR_SIZE);
+    int start = nsec ? alloc_sectors(nsec) : 0;
     if (start < 0) {
-        irq_restore(ps);
+        if (units)
+            frag_free(e.frag_sector, e.frag_unit, e.frag_units);
+        fs_unlock();
         uart_puts("fs: no space\n");
         return -1;
     }
@@ -284,52 +1179,172 @@ int fs_create(const char *name, const void *data, uint32_t size)
     const uint8_t *src = (const uint8_t *)data;
     uint32_t remaining = size;
     for (int s = 0; s < nsec; s++) {
-        uint32_t addr = FS_DATA_ADDR + (uint32_t)(start + s) * FS_SECTOR_SIZE;
+        uint32_t addr = data_addr((uint32_t)(start + s));
         flash_erase_sector(addr);
 
         uint32_t chunk = remaining > FS_SECTOR_SIZE ? FS_SECTOR_SIZE : remaining;
-        /* Pad to 4-byte alignment for SPIWrite */
-        uint32_t write_len = (chunk + 3) & ~3u;
-        flash_write(addr, src, write_len);
+        flash_write_padded(addr, src, chunk);
         src += chunk;
         remaining -= chunk;
     }
+    if (remaining)
+        flash_patch(frag_addr(&e), src, remaining);
+    bmap_set(start, nsec, 1);
+
+    /* Add directory entry */
+    e.start_sector = (uint16_t)start;
+    e.sector_count = nsec;
+    if (add_entry(&e, bucket) < 0) {
+        bmap_set(start, nsec, 0);
+        if (units)
+            frag_free(e.frag_sector, e.frag_unit, e.frag_units);
+        fs_unlock();
+        uart_puts("fs: file table full\n");
+        return -1;
+    }
+    v1_adjust_count(1);
 
-    /* Update file table entry */
-    fs_entry_t *e = table_entry(slot);
-    ets_memset(e, 0, sizeof(fs_entry_t));
-    fs_strncpy(e->name, name, FS_NAME_LEN);
-    e->size = size;
-    e->start_sector = (uint16_t)start;
-    e->sector_count = nsec;
-    write_table();
+    fs_unlock();
+    return 0;
+}
 
-    /* Update superblock */
-    fs_super_t sb;
-    read_super(&sb);
-    sb.file_count++;
-    write_super(&sb);
+int fs_create(const char *name, const void *data, uint32_t size)
+{
+    return create_file(name, data, size, 0, 0xFFFFFFFF);
+}
 
-    irq_restore(ps);
-    return 0;
+int fs_create_packed(const char *name, const void *packed, uint32_t size, uint32_t raw_size)
+{
+    if (!mounted || vol.version != 2 || raw_size == 0) return -1;
+    return create_file(name, packed, size, FS_F_COMPRESSED, raw_size);
+}
+
+/* ====== Streaming reads ====== */
+
+static void open_entry(fs_file_t *f, const fs_dirent_t *e);
+
+/* Copy the next len stored bytes (sector run, then fragment) */
+static uint32_t stored_read(fs_file_t *f, uint8_t *dst, uint32_t len)
+{
+    uint32_t done = 0;
+    while (done < len && f->spos < f->stored) {
+        uint32_t n = len - done;
+        if (n > f->stored - f->spos)
+            n = f->stored - f->spos;
+
+        uint32_t addr;
+        if (f->spos < f->full) {
+            addr = f->run_addr + f->spos;
+            if (n > f->full - f->spos)
+                n = f->full - f->spos;
+        } else {
+            addr = f->frag_addr + (f->spos - f->full);
+        }
+        flash_read(addr, dst + done, n);
+        f->spos += n;
+        done += n;
+    }
+    return done;
+}
+
+static uint32_t lz_fill(void *ctx, uint8_t *buf, uint32_t max)
+{
+    return stored_read((fs_file_t *)ctx, buf, max);
+}
+
+static void open_entry(fs_file_t *f, const fs_dirent_t *e)
+{
+    f->stored = e->size;
+    f->full = (uint32_t)e->sector_count * FS_SECTOR_SIZE;
+    f->run_addr = data_addr(e->start_sector);
+    f->frag_addr = has_frag(e) ? frag_addr(e) : 0;
+    f->flags = e->flags;
+    f->size = (e->flags & FS_F_COMPRESSED) ? e->raw_size : e->size;
+    f->pos = 0;
+    f->spos = 0;
+    if (f->flags & FS_F_COMPRESSED)
+        lzss_dec_init(&f->lz, lz_fill, f);
+}
+
+int fs_open(fs_file_t *f, const char *name)
+{
+    if (!mounted) return -1;
+
+    fs_read_lock();
+    fs_dirent_t e;
+    int bucket;
+    int rc = -1;
+    if (lookup(name, &e, &bucket) >= 0 && e.type == FS_TYPE_FILE) {
+        open_entry(f, &e);
+        rc = 0;
+    }
+    fs_read_unlock();
+    return rc;
+}
+
+/* Read through a handle; caller holds the read lock */
+static int file_read(fs_file_t *f, void *buf, uint32_t len)
+{
+    if (f->pos >= f->size)
+        return 0;
+    if (len > f->size - f->pos)
+        len = f->size - f->pos;
+
+    uint32_t n;
+    if (f->flags & FS_F_COMPRESSED)
+        n = lzss_decode(&f->lz, (uint8_t *)buf, len);
+    else
+        n = stored_read(f, (uint8_t *)buf, len);
+    f->pos += n;
+    return (int)n;
+}
+
+int fs_fread(fs_file_t *f, void *buf, uint32_t len)
+{
+    fs_read_lock();
+    int n = file_read(f, buf, len);
+    fs_read_unlock();
+    return n;
 }
 
 int fs_read(const char *name, void *buf, uint32_t max_size)
 {
     if (!mounted) return -1;
 
-    read_table();
-    int idx = find_file(name);
-    if (idx < 0) return -1;
+    fs_read_lock();
+    fs_dirent_t e;
+    int bucket;
+    if (lookup(name, &e, &bucket) < 0 || e.type != FS_TYPE_FILE) {
+        fs_read_unlock();
+        return -1;
+    }
 
-    fs_entry_t *e = table_entry(idx);
-    uint32_t to_read = e->size < max_size ? e->size : max_size;
+    if (e.flags & FS_F_COMPRESSED) {
+        /* Decoder state is ~300 bytes: keep it off the task stack */
+        fs_file_t *rd = (fs_file_t *)heap_alloc(sizeof(fs_file_t));
+        int n = -1;
+        if (rd) {
+            open_entry(rd, &e);
+            n = file_read(rd, buf, max_size);
+            heap_free(rd);
+        }
+        fs_read_unlock();
+        return n;
+    }
 
-    /* Round up to 4-byte boundary for SPIRead */
-    uint32_t read_len = (to_read + 3) & ~3u;
-    uint32_t addr = FS_DATA_ADDR + (uint32_t)e->start_sector * FS_SECTOR_SIZE;
-    flash_read(addr, buf, read_len);
+    uint32_t to_read = e.size < max_size ? e.size : max_size;
 
+    /* Full sectors first, then the tail fragment. Exact lengths:
+     * flash_read handles an unaligned tail without overrunning buf. */
+    uint32_t full = (uint32_t)e.sector_count * FS_SECTOR_SIZE;
+    if (full > to_read)
+        full = to_read;
+    if (full)
+        flash_read(data_addr(e.start_sector), buf, full);
+    if (to_read > full && has_frag(&e))
+        flash_read(frag_addr(&e), (uint8_t *)buf + full, to_read - full);
+
+    fs_read_unlock();
     return (int)to_read;
 }
 
@@ -337,26 +1352,20 @@ int fs_delete(const char *name)
 {
     if (!mounted) return -1;
 
-    uint32_t ps = irq_save();
-    read_table();
+    fs_lock();
 
-    int idx = find_file(name);
-    if (idx < 0) {
-        irq_restore(ps);
+    fs_dirent_t e;
+    int bucket;
+    int idx = lookup(name, &e, &bucket);
+    if (idx < 0 || e.type != FS_TYPE_FILE) {
+        fs_unlock();
         return -1;
     }
 
-    /* Clear the entry */
-    ets_memset(table_entry(idx), 0, sizeof(fs_entry_t));
-    write_table();
+    remove_entry(idx, &e);
+    v1_adjust_count(-1);
 
-    /* Update superblock */
-    fs_super_t sb;
-    read_super(&sb);
-    if (sb.file_count > 0) sb.file_count--;
-    write_super(&sb);
-
-    irq_restore(ps);
+    fs_unlock();
     return 0;
 }
 
@@ -364,54 +1373,123 @@ int fs_stat(const char *name)
 {
     if (!mounted) return -1;
 
-    read_table();
-    int idx = find_file(name);
-    if (idx < 0) return -1;
-
-    return (int)table_entry(idx)->size;
+    fs_read_lock();
+    fs_dirent_t e;
+    int bucket;
+    int rc = -1;
+    if (lookup(name, &e, &bucket) >= 0 && e.type == FS_TYPE_FILE)
+        rc = (int)((e.flags & FS_F_COMPRESSED) ? e.raw_size : e.size);
+    fs_read_unlock();
+    return rc;
 }
 
-void fs_list(void)
+/* ====== Directory listing ====== */
+
+int fs_opendir(fs_dir_t *d, const char *pattern)
 {
-    if (!mounted) {
-        uart_puts("fs: not mounted\n");
-        return;
+    d->slot = 0xFFFF;                   /* reads nothing until opened */
+    if (!mounted) return -1;
+
+    d->parent = FS_DIR_ALL;
+    d->prefix_len = 0;
+    d->prefix[0] = '\0';
+    d->dir[0] = '\0';
+    if (!pattern) {
+        d->slot = 0;
+        return 0;
     }
 
-    read_table();
+    if (*pattern == '/') pattern++;
+    const char *slash = pattern;
+    while (*slash && *slash != '/') slash++;
+
+    d->parent = FS_ROOT;
+    if (*slash == '/') {
+        int dlen = (int)(slash - pattern);
+        if (dlen == 0 || dlen >= FS_NAME_LEN || vol.version != 2)
+            return -1;
+        for (int i = 0; i < dlen; i++) d->dir[i] = pattern[i];
+        d->dir[dlen] = '\0';
+
+        fs_read_lock();
+        fs_dirent_t e;
+        int b;
+        int ds = find_entry(FS_ROOT, d->dir, &e, &b);
+        fs_read_unlock();
+        if (ds < 0 || e.type != FS_TYPE_DIR)
+            return -1;
+        d->parent = (uint16_t)ds;
+        pattern = slash + 1;
+    }
 
-    uart_puts("Name                     Size  Sec\n");
-    int count = 0;
-    for (int i = 0; i < FS_MAX_FILES; i++) {
-        fs_entry_t *e = table_entry(i);
-        if (entry_free(e)) continue;
+    int len = fs_strlen(pattern);
+    if (len >= FS_NAME_LEN)
+        return -1;
+    for (int i = 0; i < len; i++)
+        if (pattern[i] == '/') return -1;
+    fs_strncpy(d->prefix, pattern, FS_NAME_LEN);
+    d->prefix_len = (uint8_t)len;
+    d->slot = 0;
+    return 0;
+}
 
-        /* Print name padded to 25 chars */
-        const char *p = e->name;
-        int len = 0;
-        while (p[len]) len++;
-        uart_puts(e->name);
-        for (int j = len; j < 25; j++) uart_putc(' ');
+/* Does the entry's name start with the cursor prefix? */
+static int prefix_match(const fs_dir_t *d, const char *name)
+{
+    for (int i = 0; i < d->prefix_len; i++)
+        if (name[i] != d->prefix[i]) return 0;
+    return 1;
+}
 
-        uart_put_dec(e->size);
-        uart_puts("  ");
-        uart_put_dec(e->sector_count);
-        uart_puts("\n");
-        count++;
+int fs_readdir(fs_dir_t *d, fs_dirinfo_t *info)
+{
+    if (!mounted) return 0;
+
+    /* One slot at a time from the (cached) directory; the lock is only
+     * held inside the call, so the caller may block between entries */
+    fs_read_lock();
+    fs_dirent_t e;
+    int found = 0;
+    while (!found && d->slot < vol.hwm) {
+        read_entry(d->slot++, &e);
+        if (entry_free(&e) || (e.flags & FS_F_PENDING)) continue;
+        if (d->parent != FS_DIR_ALL && e.parent != d->parent) continue;
+        found = prefix_match(d, e.name);
     }
 
-    if (count == 0)
-        uart_puts("(empty)\n");
+    if (found) {
+        int len = 0;
+        if (d->parent == FS_DIR_ALL && e.parent != FS_ROOT) {
+            fs_dirent_t p;
+            read_entry(e.parent, &p);
+            fs_strncpy(info->name, p.name, FS_NAME_LEN);
+            len = fs_strlen(info->name);
+        } else if (d->parent != FS_ROOT && d->parent != FS_DIR_ALL) {
+            fs_strncpy(info->name, d->dir, FS_NAME_LEN);
+            len = fs_strlen(info->name);
+        }
+        if (len)
+            info->name[len++] = '/';
+        fs_strncpy(info->name + len, e.name, FS_NAME_LEN);
+
+        info->stored = e.type == FS_TYPE_FILE ? e.size : 0;
+        info->size = (e.flags & FS_F_COMPRESSED) ? e.raw_size : info->stored;
+        info->sectors = e.type == FS_TYPE_FILE ? e.sector_count : 0;
+        info->frag_units = has_frag(&e) ? e.frag_units : 0;
+        info->type = e.type;
+        info->flags = e.flags;
+    }
+    fs_read_unlock();
+    return found;
 }
 
 uint32_t fs_free(void)
 {
     if (!mounted) return 0;
-
-    read_table();
-    uint8_t bmap[BITMAP_BYTES];
-    build_bitmap(bmap);
-    return count_free(bmap) * FS_SECTOR_SIZE;
+    fs_read_lock();
+    uint32_t n = count_free() * FS_SECTOR_SIZE + frag_free_bytes();
+    fs_read_unlock();
+    return n;
 }
 
 int fs_overwrite(const char *name, const void *data, uint32_t size)
@@ -419,60 +1497,58 @@ int fs_overwrite(const char *name, const void *data, uint32_t size)
     if (!mounted) return -1;
     if (name[0] == '\0' || size == 0) return -1;
 
-    uint32_t ps = irq_save();
-    read_table();
+    fs_lock();
 
-    int idx = find_file(name);
+    fs_dirent_t e;
+    int bucket;
+    int idx = lookup(name, &e, &bucket);
     if (idx < 0) {
         /* File doesn't exist — create it */
-        irq_restore(ps);
+        fs_unlock();
         return fs_create(name, data, size);
     }
+    if (e.type != FS_TYPE_FILE) {
+        fs_unlock();
+        return -1;
+    }
 
-    fs_entry_t *e = table_entry(idx);
     uint16_t new_nsec = (uint16_t)((size + FS_SECTOR_SIZE - 1) / FS_SECTOR_SIZE);
 
-    if (new_nsec <= e->sector_count) {
+    if (new_nsec <= e.sector_count && !has_frag(&e) && !tail_units(size) &&
+        !(e.flags & FS_F_COMPRESSED)) {
         /* Fits in existing sectors — erase and rewrite in place */
-        uint16_t start = e->start_sector;
+        uint16_t start = e.start_sector;
 
         /* Erase all old sectors */
-        for (int s = 0; s < e->sector_count; s++) {
-            uint32_t addr = FS_DATA_ADDR + (uint32_t)(start + s) * FS_SECTOR_SIZE;
-            flash_erase_sector(addr);
-        }
+        for (int s = 0; s < e.sector_count; s++)
+            flash_erase_sector(data_addr((uint32_t)(start + s)));
 
         /* Write new data */
         const uint8_t *src = (const uint8_t *)data;
         uint32_t remaining = size;
         for (int s = 0; s < new_nsec; s++) {
-            uint32_t addr = FS_DATA_ADDR + (uint32_t)(start + s) * FS_SECTOR_SIZE;
+            uint32_t addr = data_addr((uint32_t)(start + s));
             uint32_t chunk = remaining > FS_SECTOR_SIZE ? FS_SECTOR_SIZE : remaining;
-            uint32_t write_len = (chunk + 3) & ~3u;
-            flash_write(addr, src, write_len);
+            flash_write_padded(addr, src, chunk);
             src += chunk;
             remaining -= chunk;
         }
 
         /* Update entry: new size & sector count */
-        e->size = size;
-        e->sector_count = new_nsec;
-        write_table();
+        bmap_set(start + new_nsec, e.sector_count - new_nsec, 0);
+        e.size = size;
+        e.sector_count = new_nsec;
+        rewrite_entry(idx, &e);
 
-        irq_restore(ps);
+        fs_unlock();
         return 0;
     }
 
-    /* Doesn't fit — delete and recreate */
-    ets_memset(e, 0, sizeof(fs_entry_t));
-    write_table();
+    /* Doesn't fit (or involves a fragment) — delete and recreate */
+    remove_entry(idx, &e);
+    v1_adjust_count(-1);
 
-    fs_super_t sb;
-    read_super(&sb);
-    if (sb.file_count > 0) sb.file_count--;
-    write_super(&sb);
-
-    irq_restore(ps);
+    fs_unlock();
     return fs_create(name, data, size);
 }
 
@@ -480,219 +1556,362 @@ int fs_append(const char *name, const void *data, uint32_t size)
 {
     if (!mounted || size == 0) return -1;
 
-    uint32_t ps = irq_save();
-    read_table();
+    fs_lock();
 
-    int idx = find_file(name);
-    if (idx < 0) {
-        irq_restore(ps);
+    fs_dirent_t e;
+    int bucket;
+    int idx = lookup(name, &e, &bucket);
+    if (idx < 0 || e.type != FS_TYPE_FILE) {
+        fs_unlock();
+        return -1;
+    }
+    if (e.flags & FS_F_COMPRESSED) {
+        fs_unlock();
+        uart_puts("fs: can't append to a compressed file\n");
         return -1;
     }
 
-    fs_entry_t *e = table_entry(idx);
-    uint32_t old_size = e->size;
+    uint32_t old_size = e.size;
     uint32_t new_total = old_size + size;
-    uint16_t start = e->start_sector;
-    uint16_t nsec = e->sector_count;
 
-    uint16_t need_nsec = (uint16_t)((new_total + FS_SECTOR_SIZE - 1) / FS_SECTOR_SIZE);
-    if (need_nsec > nsec) {
-        irq_restore(ps);
-        uart_puts("fs: append won't fit in allocated sectors\n");
+    /* Room left in the last sector or the tail fragment is filled in
+     * place, program-only when the bytes are still erased. */
+    uint32_t cap = (uint32_t)e.sector_count * FS_SECTOR_SIZE;
+    if (has_frag(&e))
+        cap += (uint32_t)e.frag_units * FS_FRAG_UNIT;
+    if (new_total > cap && grow_file(&e, new_total) < 0) {
+        fs_unlock();
+        uart_puts("fs: no space\n");
         return -1;
     }
 
-    /* Save entry info — we'll reuse sec_buf for data ops */
-    const uint8_t *src = (const uint8_t *)data;
-    uint32_t remaining = size;
-    uint32_t write_pos = old_size;
+    file_write(&e, old_size, (const uint8_t *)data, size);
 
-    /* Handle partial last sector: read-modify-write */
-    uint32_t offset_in_sec = write_pos % FS_SECTOR_SIZE;
-    if (offset_in_sec != 0) {
-        uint32_t sec_idx = write_pos / FS_SECTOR_SIZE;
-        uint32_t addr = FS_DATA_ADDR + (uint32_t)(start + sec_idx) * FS_SECTOR_SIZE;
+    /* Update size */
+    e.size = new_total;
+    rewrite_entry(idx, &e);
 
-        flash_read(addr, sec_buf, FS_SECTOR_SIZE);
+    fs_unlock();
+    return 0;
+}
 
-        uint32_t space = FS_SECTOR_SIZE - offset_in_sec;
-        uint32_t chunk = remaining < space ? remaining : space;
-        ets_memcpy(sec_buf + offset_in_sec, src, chunk);
+int fs_rename(const char *old_name, const char *new_name)
+{
+    if (!mounted) return -1;
+    if (old_name[0] == '\0' || new_name[0] == '\0') return -1;
 
-        flash_erase_sector(addr);
-        flash_write(addr, sec_buf, FS_SECTOR_SIZE);
+    fs_lock();
 
-        src += chunk;
-        remaining -= chunk;
-        write_pos += chunk;
+    fs_dirent_t e;
+    int bucket;
+    int idx = lookup(old_name, &e, &bucket);
+    if (idx < 0) {
+        fs_unlock();
+        return -1;
     }
 
-    /* Write remaining full sectors */
-    while (remaining > 0) {
-        uint32_t sec_idx = write_pos / FS_SECTOR_SIZE;
-        uint32_t addr = FS_DATA_ADDR + (uint32_t)(start + sec_idx) * FS_SECTOR_SIZE;
-        uint32_t chunk = remaining > FS_SECTOR_SIZE ? FS_SECTOR_SIZE : remaining;
-
-        flash_erase_sector(addr);
-        uint32_t write_len = (chunk + 3) & ~3u;
-        flash_write(addr, src, write_len);
+    uint16_t parent;
+    char leaf[FS_NAME_LEN];
+    if (split_path(new_name, &parent, leaf) < 0 ||
+        (e.type == FS_TYPE_DIR && parent != FS_ROOT)) {
+        fs_unlock();
+        uart_puts("fs: bad path\n");
+        return -1;
+    }
 
-        src += chunk;
-        remaining -= chunk;
-        write_pos += chunk;
+    /* Check new name doesn't already exist */
+    fs_dirent_t tmp;
+    int new_bucket;
+    if (find_entry(parent, leaf, &tmp, &new_bucket) >= 0) {
+        fs_unlock();
+        uart_puts("fs: target name exists\n");
+        return -1;
     }
 
-    /* Reload table and update size */
-    read_table();
-    table_entry(idx)->size = new_total;
-    write_table();
+    uint32_t old_hash = e.hash;
+    fs_strncpy(e.name, leaf, FS_NAME_LEN);
+    e.parent = parent;
+    e.hash = name_hash(parent, leaf);
+    rewrite_entry(idx, &e);
 
-    irq_restore(ps);
+    if (vol.version == 2) {
+        hash_remove(old_hash, idx);
+        hash_insert(e.hash, idx, new_bucket);
+    }
+
+    fs_unlock();
     return 0;
 }
 
-int fs_rename(const char *old_name, const char *new_name)
+int fs_mkdir(const char *name)
 {
-    if (!mounted) return -1;
-    if (old_name[0] == '\0' || new_name[0] == '\0') return -1;
+    if (!mounted || vol.version != 2) return -1;
 
-    uint32_t ps = irq_save();
-    read_table();
+    fs_lock();
 
-    int idx = find_file(old_name);
-    if (idx < 0) {
-        irq_restore(ps);
+    uint16_t parent;
+    char leaf[FS_NAME_LEN];
+    fs_dirent_t e;
+    int bucket;
+    if (split_path(name, &parent, leaf) < 0 || parent != FS_ROOT ||
+        find_entry(parent, leaf, &e, &bucket) >= 0) {
+        fs_unlock();
         return -1;
     }
 
-    /* Check new name doesn't already exist */
-    if (find_file(new_name) >= 0) {
-        irq_restore(ps);
-        uart_puts("fs: target name exists\n");
+    init_dirent(&e, FS_ROOT, leaf, FS_TYPE_DIR);
+    int slot = add_entry(&e, bucket);
+
+    fs_unlock();
+    return slot < 0 ? -1 : 0;
+}
+
+int fs_rmdir(const char *name)
+{
+    if (!mounted || vol.version != 2) return -1;
+
+    fs_lock();
+
+    fs_dirent_t e;
+    int bucket;
+    int idx = lookup(name, &e, &bucket);
+    if (idx < 0 || e.type != FS_TYPE_DIR) {
+        fs_unlock();
         return -1;
     }
 
-    fs_strncpy(table_entry(idx)->name, new_name, FS_NAME_LEN);
-    write_table();
+    /* Must be empty */
+    fs_dirent_t c;
+    for (int i = 0; i < vol.hwm; i++) {
+        read_entry(i, &c);
+        if (!entry_free(&c) && c.parent == (uint16_t)idx) {
+            fs_unlock();
+            return -1;
+        }
+    }
+
+    remove_entry(idx, &e);
 
-    irq_restore(ps);
+    fs_unlock();
     return 0;
 }
 
-int fs_upload(const char *name, uint32_t total_size)
+/* fs_upload receive buffer size (two are taken from the heap) */
+#define UPLOAD_CHUNK    1024
+
+/* Publish a finished upload: clear FS_F_PENDING, a 1->0 program of the
+ * word holding the flags (v1 keeps the mark in RAM only) */
+static void upload_commit(int slot, fs_dirent_t *e)
+{
+    fs_lock();
+    e->flags &= (uint8_t)~FS_F_PENDING;
+    if (vol.version == 2) {
+        uint32_t off = __builtin_offsetof(fs_dirent_t, parent);
+        uint32_t w;
+        ets_memcpy(&w, (const uint8_t *)e + off, 4);
+        flash_program_word(slot_addr(slot) + off, w);
+    }
+    vol.pending = -1;
+    fs_unlock();
+}
+
+/* Drop an upload that failed; fs_delete cannot see it while pending */
+static void upload_abort(int slot, const fs_dirent_t *e)
+{
+    fs_lock();
+    remove_entry(slot, e);
+    v1_adjust_count(-1);
+    vol.pending = -1;
+    fs_unlock();
+}
+
+int fs_upload(const char *name, uint32_t total_size, uint32_t raw_size)
 {
     if (!mounted) return -1;
     if (name[0] == '\0' || total_size == 0) return -1;
+    if (raw_size && vol.version != 2) {
+        uart_puts("ERR compressed files need a v2 volume\n");
+        return -1;
+    }
 
-    uint32_t ps = irq_save();
+    fs_lock();
 
-    /* Delete existing file if any */
-    read_table();
-    int old_idx = find_file(name);
-    if (old_idx >= 0) {
-        ets_memset(table_entry(old_idx), 0, sizeof(fs_entry_t));
-        write_table();
-        fs_super_t sb;
-        read_super(&sb);
-        if (sb.file_count > 0) sb.file_count--;
-        write_super(&sb);
-        /* Reload table after superblock write (write_super uses sec_buf) */
-        read_table();
+    uint16_t parent;
+    char leaf[FS_NAME_LEN];
+    if (split_path(name, &parent, leaf) < 0) {
+        fs_unlock();
+        uart_puts("fs: bad path\n");
+        return -1;
     }
 
-    /* Find free slot */
-    int slot = find_free_slot();
-    if (slot < 0) {
-        irq_restore(ps);
-        uart_puts("fs: file table full\n");
-        return -1;
+    /* Delete existing file if any */
+    fs_dirent_t e;
+    int bucket;
+    int old_idx = find_entry(parent, leaf, &e, &bucket);
+    if (old_idx >= 0) {
+        if (e.flags & FS_F_PENDING) {
+            fs_unlock();
+            uart_puts("fs: upload in progress\n");
+            return -1;
+        }
+        if (e.type != FS_TYPE_FILE) {
+            fs_unlock();
+            uart_puts("fs: is a directory\n");
+            return -1;
+        }
+        remove_entry(old_idx, &e);
+        v1_adjust_count(-1);
+        find_entry(parent, leaf, &e, &bucket);
     }
 
     /* Allocate sectors */
     uint16_t nsec = (uint16_t)((total_size + FS_SECTOR_SIZE - 1) / FS_SECTOR_SIZE);
-    uint8_t bmap[BITMAP_BYTES];
-    build_bitmap(bmap);
-
-    int start = alloc_sectors(bmap, nsec);
+    int start = alloc_sectors(nsec);
     if (start < 0) {
-        irq_restore(ps);
+        fs_unlock();
         uart_puts("fs: no space\n");
         return -1;
     }
 
-    /* Create file table entry NOW (so sectors are reserved) */
-    fs_entry_t *e = table_entry(slot);
-    ets_memset(e, 0, sizeof(fs_entry_t));
-    fs_strncpy(e->name, name, FS_NAME_LEN);
-    e->size = total_size;
-    e->start_sector = (uint16_t)start;
-    e->sector_count = nsec;
-    write_table();
-
-    /* Update superblock */
-    fs_super_t sb;
-    read_super(&sb);
-    sb.file_count++;
-    write_super(&sb);
-
-    irq_restore(ps);
+    /* Create file table entry NOW (so sectors are reserved), pending
+     * until the data is written */
+    init_dirent(&e, parent, leaf, FS_TYPE_FILE);
+    e.size = total_size;
+    e.flags = FS_F_PENDING;
+    if (raw_size) {
+        e.flags |= FS_F_COMPRESSED;
+        e.raw_size = raw_size;
+    }
+    e.start_sector = (uint16_t)start;
+    e.sector_count = nsec;
+    bmap_set(start, nsec, 1);
+    int slot = add_entry(&e, bucket);
+    if (slot < 0) {
+        bmap_set(start, nsec, 0);
+        fs_unlock();
+        uart_puts("fs: file table full\n");
+        return -1;
+    }
+    if (vol.version == 1)
+        vol.pending = (int16_t)slot;
+    v1_adjust_count(1);
+
+    fs_unlock();
+
+    /* Receive through two small buffers: each sector's erase is queued
+     * when its data starts to arrive, and every full chunk is queued for
+     * programming, so the flash task works while the next chunk comes in.
+     * A buffer is refilled only after its program has completed. */
+    uint8_t *bufs = (uint8_t *)heap_alloc(2 * UPLOAD_CHUNK);
+    if (!bufs) {
+        upload_abort(slot, &e);
+        uart_puts("ERR no memory\n");
+        return -1;
+    }
 
     /* Signal PC: ready to receive */
     uart_puts("READY\n");
 
-    /* Receive data sector by sector */
+    flashio_req_t erase_req, prog_req[2];
+    sem_t done[2];
+    int busy[2] = { 0, 0 };
+    int b = 0;
+    int err = 0;
+    sem_init(&done[0], 0);
+    sem_init(&done[1], 0);
+
     uint16_t crc = 0xFFFF;
     uint32_t received = 0;
 
-    for (uint16_t sec = 0; sec < nsec; sec++) {
-        uint32_t chunk = total_size - received;
-        if (chunk > FS_SECTOR_SIZE) chunk = FS_SECTOR_SIZE;
-
-        /* Read chunk bytes from UART into sec_buf */
-        uint32_t got = 0;
-        uint32_t timeout_start = get_tick_count();
-        while (got < chunk) {
-            int c = uart_getc();
-            if (c >= 0) {
-                sec_buf[got++] = (uint8_t)c;
-                timeout_start = get_tick_count();
-            } else {
-                task_yield();
-                if (get_tick_count() - timeout_start > 10 * TICK_HZ) {
-                    /* Timeout — delete the partial file */
-                    fs_delete(name);
-                    uart_puts("ERR timeout\n");
-                    return -1;
-                }
+    for (uint16_t sec = 0; sec < nsec && !err; sec++) {
+        uint32_t addr = data_addr((uint32_t)(start + sec));
+        uint32_t sec_len = total_size - received;
+        if (sec_len > FS_SECTOR_SIZE) sec_len = FS_SECTOR_SIZE;
+
+        if (sec > 0 && flashio_wait(&erase_req) < 0)
+            err = 1;
+        flashio_req_init(&erase_req, FLASHIO_ERASE, addr, nullptr, 0, nullptr);
+        flashio_submit(&erase_req);
+
+        uint32_t off = 0;
+        while (off < sec_len && !err) {
+            uint32_t n = sec_len - off;
+            if (n > UPLOAD_CHUNK) n = UPLOAD_CHUNK;
+            uint8_t *buf = bufs + b * UPLOAD_CHUNK;
+            if (busy[b]) {
+                if (flashio_wait(&prog_req[b]) < 0)
+                    err = 1;
+                busy[b] = 0;
             }
-        }
 
-        /* Update CRC */
-        for (uint32_t i = 0; i < got; i++) {
-            crc ^= (uint16_t)sec_buf[i] << 8;
-            for (int b = 0; b < 8; b++) {
-                if (crc & 0x8000)
-                    crc = (crc << 1) ^ 0x1021;
-                else
-                    crc <<= 1;
+            /* Read n bytes from UART */
+            uint32_t got = 0;
+            uint32_t timeout_start = get_tick_count();
+            while (got < n) {
+                int c = uart_getc();
+                if (c >= 0) {
+                    buf[got++] = (uint8_t)c;
+                    timeout_start = get_tick_count();
+                } else {
+                    task_yield();
+                    if (get_tick_count() - timeout_start > 10 * TICK_HZ)
+                        break;
+                }
+            }
+            if (got < n) {
+                /* Timeout — delete the partial file */
+                flashio_wait(&erase_req);
+                for (int i = 0; i < 2; i++)
+                    if (busy[i]) flashio_wait(&prog_req[i]);
+                heap_free(bufs);
+                upload_abort(slot, &e);
+                uart_puts("ERR timeout\n");
+                return -1;
             }
-        }
 
-        received += got;
+            /* Update CRC */
+            for (uint32_t i = 0; i < n; i++) {
+                crc ^= (uint16_t)buf[i] << 8;
+                for (int k = 0; k < 8; k++) {
+                    if (crc & 0x8000)
+                        crc = (crc << 1) ^ 0x1021;
+                    else
+                        crc <<= 1;
+                }
+            }
 
-        /* Pad remaining bytes in sector to 0xFF */
-        for (uint32_t i = got; i < FS_SECTOR_SIZE; i++)
-            sec_buf[i] = 0xFF;
+            /* Pad the last word with 0xFF (erased) so appends can follow */
+            uint32_t n4 = (n + 3) & ~3u;
+            for (uint32_t i = n; i < n4; i++)
+                buf[i] = 0xFF;
 
-        /* Write sector to flash */
-        uint32_t addr = FS_DATA_ADDR + (uint32_t)(start + sec) * FS_SECTOR_SIZE;
-        flash_erase_sector(addr);
-        flash_write(addr, sec_buf, FS_SECTOR_SIZE);
+            flashio_req_init(&prog_req[b], FLASHIO_PROGRAM, addr + off, buf, n4, &done[b]);
+            flashio_submit(&prog_req[b]);
+            busy[b] = 1;
+            b ^= 1;
+            off += n;
+        }
+        received += off;
 
         /* ACK this sector — PC waits for '#' before sending next chunk */
-        uart_putc('#');
+        if (!err)
+            uart_putc('#');
     }
 
+    if (flashio_wait(&erase_req) < 0)
+        err = 1;
+    for (int i = 0; i < 2; i++) {
+        if (busy[i] && flashio_wait(&prog_req[i]) < 0)
+            err = 1;
+    }
+    heap_free(bufs);
+    if (err) {
+        upload_abort(slot, &e);
+        uart_puts("ERR flash\n");
+        return -1;
+    }
+    upload_commit(slot, &e);
+
     /* Done */
     uart_puts("\nOK ");
     uart_put_hex(crc);
@@ -706,6 +1925,11 @@ int fs_mounted(void)
     return mounted;
 }
 
+int fs_version(void)
+{
+    return mounted ? (int)vol.version : 0;
+}
+
 uint16_t fs_crc16(const uint8_t *data, uint32_t len)
 {
     uint16_t crc = 0xFFFF;
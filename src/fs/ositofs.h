@@ -1,13 +1,21 @@
 /*
  * OsitoFS - Flat filesystem on SPI flash
  *
- * Inspired by BBC Micro's DFS: flat namespace, contiguous allocation.
- * Up to 128 files on ~3.75MB of flash.
+ * Inspired by BBC Micro's DFS: contiguous allocation, one optional
+ * level of subdirectories. Up to 4096 entries on ~3.7MB of flash.
  *
- * Flash layout (starting at FS_FLASH_BASE = 0x40000):
- *   Sector 0: Superblock (magic, version, stats)
- *   Sector 1: File table (128 entries x 32 bytes = 4096 bytes)
- *   Sector 2+: Data area (958 sectors = ~3.83MB)
+ * Flash layout, version 2 (starting at FS_FLASH_BASE = 0x40000):
+ *   Sector 0:    Superblock (magic, version, directory sector map)
+ *   Sector 1-4:  Hash index (8192 x 16-bit buckets: name -> dir slot)
+ *   Sector 5+:   Data area (955 sectors). Directory sectors (64 entries
+ *                x 64 bytes each) are allocated from here as it grows.
+ *
+ * A file is a contiguous run of full sectors plus an optional tail
+ * fragment: 1-8 units of 256 bytes inside a sector shared with the
+ * tails of other files. A 29-byte script costs 256 bytes, not 4KB.
+ *
+ * Version 1 volumes (single 128-entry table in sector 1, data from
+ * sector 2) still mount and stay version 1 until the next 'fs format'.
  *
  * Usage:
  *   fs_init();                            // mount
@@ -15,11 +23,13 @@
  *   fs_create("hello.txt", data, len);    // write file
  *   fs_read("hello.txt", buf, sizeof buf); // read file
  *   fs_delete("hello.txt");               // delete file
+ *   fs_mkdir("games");                    // then "games/elite.zf"
  */
 #ifndef OSITO_FS_H
 #define OSITO_FS_H
 
 #include "osito.h"
+#include "fs/lzss.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -27,14 +37,43 @@ extern "C" {
 
 /* Derived constants */
 #define FS_SUPER_ADDR   FS_FLASH_BASE
+#define FS_MAGIC        0x4F534654  /* "OSFT" */
+#define FS_VERSION      2
+
+/* Version 1 layout: one table sector, data from sector 2 */
 #define FS_TABLE_ADDR   (FS_FLASH_BASE + FS_SECTOR_SIZE)
 #define FS_DATA_ADDR    (FS_FLASH_BASE + 2 * FS_SECTOR_SIZE)
 #define FS_DATA_SECTORS ((FS_FLASH_END - FS_DATA_ADDR) / FS_SECTOR_SIZE)
+#define FS_V1_MAX_FILES (FS_SECTOR_SIZE / 32)
 
-#define FS_MAGIC        0x4F534654  /* "OSFT" */
-#define FS_VERSION      1
+/* Version 2 layout: hash index after the superblock, then data */
+#define FS_HASH_ADDR    (FS_FLASH_BASE + FS_SECTOR_SIZE)
+#define FS_HASH_SECTORS (FS_HASH_BUCKETS * 2 / FS_SECTOR_SIZE)
+#define FS_V2_DATA_ADDR (FS_HASH_ADDR + FS_HASH_SECTORS * FS_SECTOR_SIZE)
+#define FS_DIR_PER_SECTOR (FS_SECTOR_SIZE / 64)
+
+/* Fragments: small files and file tails share sectors in 256-byte
+ * units. Tails up to FS_FRAG_MAX_UNITS units are packed (v2 only). */
+#define FS_FRAG_UNIT      256
+#define FS_FRAG_PER_SECTOR (FS_SECTOR_SIZE / FS_FRAG_UNIT)
+#define FS_FRAG_MAX_UNITS 8
 
-/* File table entry (32 bytes) */
+/* Entry flags */
+#define FS_F_COMPRESSED 0x01    /* data is an LZSS stream (see lzss.h) */
+#define FS_F_PENDING    0x80    /* upload in progress: hidden until its data
+                                 * is in; cleared by programming the bit */
+
+/* Parent of top-level entries */
+#define FS_ROOT         0xFFFF
+
+/* fs_opendir(nullptr): every entry, any level */
+#define FS_DIR_ALL      0xFFFE
+
+/* Entry types */
+#define FS_TYPE_FILE    0x01
+#define FS_TYPE_DIR     0x02
+
+/* Version 1 file table entry (32 bytes) */
 typedef struct {
     char     name[FS_NAME_LEN];  /* 24: null-terminated filename */
     uint32_t size;               /*  4: file size in bytes */
@@ -42,34 +81,111 @@ typedef struct {
     uint16_t sector_count;       /*  2: sectors used */
 } __attribute__((packed)) fs_entry_t;
 
-/* Superblock (4096 bytes, one sector) */
+/* Version 2 directory entry (64 bytes). Erased (0xFF) slots are free
+ * and can be programmed without an erase; name[0] == 0 marks a
+ * deleted slot. Version 1 entries are converted to this in RAM. */
+typedef struct {
+    char     name[FS_NAME_LEN];  /* 24: null-terminated name (one component) */
+    uint32_t size;               /*  4: stored size in bytes */
+    uint16_t start_sector;       /*  2: first data sector */
+    uint16_t sector_count;       /*  2: full sectors used */
+    uint16_t parent;             /*  2: slot of parent dir, or FS_ROOT */
+    uint8_t  type;               /*  1: FS_TYPE_FILE / FS_TYPE_DIR */
+    uint8_t  flags;              /*  1: FS_F_* */
+    uint32_t hash;               /*  4: name_hash(parent, name) */
+    uint16_t frag_sector;        /*  2: data sector holding the tail */
+    uint8_t  frag_unit;          /*  1: first 256-byte unit of the tail */
+    uint8_t  frag_units;         /*  1: tail units, 0xFF = no tail fragment */
+    uint32_t raw_size;           /*  4: decompressed size (FS_F_COMPRESSED) */
+    uint8_t  reserved[16];       /* 16: 0xFF, room for new fields */
+} __attribute__((packed, aligned(4))) fs_dirent_t;
+
+/* Superblock (first bytes of sector 0) */
 typedef struct {
     uint32_t magic;
     uint32_t version;
     uint32_t total_sectors;     /* data sectors available */
-    uint32_t file_count;        /* active files */
+    uint32_t file_count;        /* active files (v1; v2 counts at mount) */
+    /* Version 2 */
+    uint16_t data_start;        /* first data sector, from FS_FLASH_BASE */
+    uint16_t hash_sectors;      /* hash index sectors after the superblock */
+    uint16_t dir_sectors;       /* directory sectors in use */
+    uint16_t dir_per_sector;    /* entries per directory sector */
+    uint16_t dir_map[FS_DIR_SECTORS_MAX];  /* data sector of each dir sector */
 } fs_super_t;
 
+/* Open file for streaming reads (fs_open / fs_fread). Compressed files
+ * are decoded on the fly; size and pos count decompressed bytes. */
+typedef struct {
+    uint32_t size;              /* file size as seen by readers */
+    uint32_t pos;
+    uint32_t stored;            /* bytes on flash */
+    uint32_t spos;              /* next stored byte to fetch */
+    uint32_t full;              /* stored bytes in the sector run */
+    uint32_t run_addr;          /* flash address of the sector run */
+    uint32_t frag_addr;         /* flash address of the tail fragment */
+    uint8_t  flags;
+    lzss_dec_t lz;
+} fs_file_t;
+
+/* Directory cursor (fs_opendir / fs_readdir) */
+typedef struct {
+    uint16_t slot;              /* next directory slot to look at */
+    uint16_t parent;            /* directory listed, FS_ROOT, or FS_DIR_ALL */
+    uint8_t  prefix_len;
+    char     prefix[FS_NAME_LEN];   /* leaf names must start with this */
+    char     dir[FS_NAME_LEN];      /* name of parent ("" for the root) */
+} fs_dir_t;
+
+/* One entry returned by fs_readdir */
+typedef struct {
+    char     name[FS_PATH_LEN]; /* full path, "dir/name" below the root */
+    uint32_t size;              /* size as seen by readers (decompressed) */
+    uint32_t stored;            /* bytes on flash */
+    uint16_t sectors;           /* full data sectors */
+    uint8_t  frag_units;        /* 256-byte tail units, 0 if none */
+    uint8_t  type;              /* FS_TYPE_FILE / FS_TYPE_DIR */
+    uint8_t  flags;             /* FS_F_* */
+} fs_dirinfo_t;
+
 /* Initialize / mount the filesystem. Returns 0 if valid FS found. */
 int fs_init(void);
 
-/* Format: erase and create a fresh filesystem. */
+/* Format: erase and create a fresh (version 2) filesystem. */
 int fs_format(void);
 
 /* Create a file. Returns 0 on success, -1 on error. */
 int fs_create(const char *name, const void *data, uint32_t size);
 
+/* Create a compressed file from an LZSS stream (see lzss.h) that
+ * decodes to raw_size bytes. Returns 0 on success, -1 on error. */
+int fs_create_packed(const char *name, const void *packed, uint32_t size, uint32_t raw_size);
+
 /* Read a file into buf. Returns bytes read, or -1 if not found. */
 int fs_read(const char *name, void *buf, uint32_t max_size);
 
 /* Delete a file. Returns 0 on success, -1 if not found. */
 int fs_delete(const char *name);
 
-/* Get file size. Returns size in bytes, or -1 if not found. */
+/* Open a file for streaming reads. Returns 0, or -1 if not found. */
+int fs_open(fs_file_t *f, const char *name);
+
+/* Read the next len bytes. Returns bytes read (0 at end of file). */
+int fs_fread(fs_file_t *f, void *buf, uint32_t len);
+
+/* Get file size (decompressed). Returns size in bytes, or -1 if not found. */
 int fs_stat(const char *name);
 
-/* List all files (prints to UART). */
-void fs_list(void);
+/* Start listing entries. pattern "dir/pre" lists the entries of dir
+ * whose names start with pre; "pre" does the same for the top level
+ * ("" lists it all); nullptr walks every entry at every level.
+ * Returns 0, or -1 if not mounted or the directory doesn't exist. */
+int fs_opendir(fs_dir_t *d, const char *pattern);
+
+/* Fetch the next matching entry, in directory slot order. Returns 1,
+ * or 0 when there are no more. Entries created or deleted while the
+ * cursor is open may or may not be returned. */
+int fs_readdir(fs_dir_t *d, fs_dirinfo_t *info);
 
 /* Free space in bytes. */
 uint32_t fs_free(void);
@@ -77,20 +193,33 @@ uint32_t fs_free(void);
 /* Overwrite an existing file (or create if not found). Returns 0 on success. */
 int fs_overwrite(const char *name, const void *data, uint32_t size);
 
-/* Append data to an existing file. Returns 0 on success, -1 if not found or won't fit. */
+/* Append data to an existing file. Returns 0 on success, -1 if not found,
+ * compressed, or won't fit. */
 int fs_append(const char *name, const void *data, uint32_t size);
 
 /* Rename a file. Returns 0 on success, -1 if not found or new name exists. */
 int fs_rename(const char *old_name, const char *new_name);
 
+/* Create a top-level directory (version 2 only). Returns 0 on success. */
+int fs_mkdir(const char *name);
+
+/* Remove an empty directory. Returns 0 on success, -1 if missing or not empty. */
+int fs_rmdir(const char *name);
+
 /* Upload a file via UART (binary protocol with sector-level ACK).
  * Handles sector allocation, UART reading, flash writes internally.
+ * raw_size != 0 marks the data as an LZSS stream of that many bytes.
+ * The entry is FS_F_PENDING until every sector is written: lookups miss
+ * it and creating the same name fails. A v2 mount drops leftovers.
  * Returns CRC16 of received data on success, -1 on error. */
-int fs_upload(const char *name, uint32_t total_size);
+int fs_upload(const char *name, uint32_t total_size, uint32_t raw_size);
 
 /* Is the filesystem mounted? */
 int fs_mounted(void);
 
+/* On-disk format version of the mounted volume (0 if not mounted). */
+int fs_version(void);
+
 /* CRC16-CCITT (for upload verification) */
 uint16_t fs_crc16(const uint8_t *data, uint32_t len);
 
@@ -11,6 +11,7 @@
 #include "drivers/input.h"
 #include "gfx/wire3d.h"
 #include "gfx/ships.h"
+#include "gfx/wmodel.h"
 #include "math/matrix3.h"
 #include "kernel/task.h"
 
@@ -61,6 +62,9 @@ static void stars_update(game_state_t *g)
 
 static const char *compass_dirs[8] = {"N ","NE","E ","SE","S ","SW","W ","NW"};
 
+/* Drawn into a layer, redrawn only when a readout changes */
+static fb_layer_t hud_layer;
+
 static void hud_draw(const game_state_t *g)
 {
     /* Separator line */
@@ -89,7 +93,7 @@ static void hud_draw(const game_state_t *g)
     fb_text_puts(12, 8, comp);
 
     /* Ship name */
-    fb_text_puts(20, 8, ship_names[g->ship_idx]);
+    fb_text_puts(20, 8, wmodel_name_at(g->ship_idx));
 
     /* Mini radar box (x 0-15, y 54-62) */
     fb_line(0, 54, 15, 54);
@@ -109,8 +113,20 @@ static void hud_draw(const game_state_t *g)
     fb_set_pixel(rx, 58);
 }
 
+/* Everything hud_draw() shows depends on these */
+static uint32_t hud_key(const game_state_t *g)
+{
+    return (uint32_t)g->speed | (uint32_t)g->yaw << 8 | (uint32_t)g->ship_idx << 16;
+}
+
 /* ====== Game loop ====== */
 
+/* Ships, then any models loaded from files; the cube (0) is skipped */
+static uint8_t next_ship(uint8_t idx)
+{
+    return (uint8_t)(idx + 1 < wmodel_total() ? idx + 1 : 1);
+}
+
 void game_elite(void)
 {
     game_state_t g;
@@ -122,13 +138,19 @@ void game_elite(void)
     }
 
     g.speed = 3;
-    g.ship_idx = 0;
+    g.ship_idx = 1;
     g.rng_seed = get_tick_count();
+    orient_init(&g.orient, nullptr);
     stars_init(&g);
+    hud_layer.ready = 0;
+    uint32_t hud_shown = 0;
+    int clears = 0;             /* buffers still to start from a clear */
 
     uart_puts("elite: a/d=yaw w/s=pitch n=ship Ctrl+C=exit\n");
 
     for (;;) {
+        angle_t yaw0 = g.yaw, pitch0 = g.pitch;
+
         /* 1. Input — consume events */
         input_event_t ev;
         while ((ev = input_poll()) != INPUT_NONE) {
@@ -136,7 +158,7 @@ void game_elite(void)
             if (ev == INPUT_RIGHT) g.yaw += 4;
             if (ev == INPUT_PRESS) {
                 /* Cycle ship on button press */
-                g.ship_idx = (g.ship_idx + 1) % SHIP_COUNT;
+                g.ship_idx = next_ship(g.ship_idx);
             }
         }
 
@@ -157,31 +179,51 @@ void game_elite(void)
             case 'd':  g.yaw += 4;  break;
             case 'w':  g.pitch -= 3; break;
             case 's':  g.pitch += 3; break;
-            case 'n':  g.ship_idx = (g.ship_idx + 1) % SHIP_COUNT; break;
+            case 'n':  g.ship_idx = next_ship(g.ship_idx); break;
             }
         }
 
-        /* 2. Render */
-        fb_clear();
+        /* 2. Render: take last frame's moving parts off by drawing
+         * them again in XOR, as the original did. When the HUD
+         * changes (and at the start, when the buffers may hold another
+         * program's picture) each buffer starts from a clear. */
+        if (hud_key(&g) != hud_shown)
+            hud_layer.ready = 0;
+        if (!hud_layer.ready) {
+            fb_layer_begin(&hud_layer);
+            hud_draw(&g);
+            fb_layer_end();
+            hud_shown = hud_key(&g);
+            clears = 2;
+        }
+        if (clears > 0 || fb_erase() < 0) {
+            fb_clear();
+            fb_layer_draw(&hud_layer);
+            if (clears > 0)
+                clears--;
+        }
+        fb_set_rop(FB_ROP_XOR);
 
         /* Starfield */
         stars_update(&g);
 
-        /* Ship wireframe */
-        mat3_t rx, ry, rot;
-        mat3_rotate_x(&rx, g.pitch);
-        mat3_rotate_y(&ry, g.yaw);
-        mat3_multiply(&rot, &ry, &rx);
+        /* Ship wireframe, turned by this frame's pitch and yaw */
+        orient_turn(&g.orient, (int16_t)((int8_t)(g.pitch - pitch0) * 256),
+                    (int16_t)((int8_t)(g.yaw - yaw0) * 256), 0);
 
-        fix16_t z = (g.ship_idx == 3) ? FIX16(8) : GAME_SHIP_Z;
+        const wire_model_t *m = wmodel_at(g.ship_idx);
+        fix16_t z = (g.ship_idx == SHIP_COUNT) ? FIX16(8) : GAME_SHIP_Z;  /* coriolis */
+        if (m->radius * 2 > z)
+            z = m->radius * 2;              /* loaded model: fit its sphere */
         vec3_t pos = vec3(0, 0, z);
-        wire_render(ship_list[g.ship_idx], &rot, pos, GAME_FOCAL);
+        fb_set_clip(0, VIEW_Y_MIN, FB_WIDTH - 1, VIEW_Y_MAX);  /* keep off the HUD */
+        wire_render(m, &g.orient.m, pos, GAME_FOCAL);
+        fb_reset_clip();
 
-        /* HUD */
-        hud_draw(&g);
+        fb_set_rop(FB_ROP_OR);
 
-        /* 3. Flush + yield */
-        fb_flush();
+        /* 3. Send (drains while the next frame renders) + yield */
+        fb_swap();
         g.frame_count++;
         task_yield();
     }
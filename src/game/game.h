@@ -8,7 +8,7 @@
 #define OSITO_GAME_H
 
 #include "osito.h"
-#include "math/fixedpoint.h"
+#include "math/matrix3.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -22,14 +22,15 @@ extern "C" {
 #define HUD_Y         48
 
 typedef struct {
-    angle_t   yaw;
+    angle_t   yaw;            /* totals, for the HUD */
     angle_t   pitch;
     uint8_t   speed;          /* 0-6 */
-    uint8_t   ship_idx;       /* 0-3, index into ship_list[] */
+    uint8_t   ship_idx;       /* model index (wmodel_at), 1 = cobra */
     int8_t    star_x[STAR_COUNT];
     int8_t    star_y[STAR_COUNT];
     uint32_t  rng_seed;
     uint32_t  frame_count;
+    orient_t  orient;         /* ship orientation, turned each frame */
 } game_state_t;
 
 /* Entry point — called from shell "elite" command */
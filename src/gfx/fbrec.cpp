@@ -0,0 +1,362 @@
+/*
+ * OsitoK - Framebuffer recorder and player
+ *
+ * The recorder hooks fb_flush(). Each frame is XORed against a shadow
+ * of the previous one and the result coded as literal / skip runs
+ * into a heap buffer, which goes to flash with fs_append when full.
+ * A literal run absorbs single unchanged bytes; two in a row end it.
+ *
+ * The player decodes straight into the framebuffer, reading the file
+ * through fs_fread (and so the read cache with its read-ahead), and
+ * paces frames against the tick counter: frame n is due at
+ * start + n * TICK_HZ / fps, so rounding never accumulates.
+ */
+
+#include "gfx/fbrec.h"
+#include "drivers/video.h"
+#include "drivers/uart.h"
+#include "fs/ositofs.h"
+#include "mem/heap.h"
+#include "kernel/task.h"
+
+extern "C" {
+
+typedef struct {
+    uint32_t magic;
+    uint16_t fps;
+    uint16_t frame_bytes;
+} fbrec_header_t;
+
+static fbrec_stats_t stats;
+
+/* ====== Recorder ====== */
+
+static char rec_name[FS_PATH_LEN];
+static uint8_t *rec_mem = nullptr;     /* [previous frame][chunk buffer] */
+static uint8_t *rec_prev;
+static uint8_t *rec_buf;
+static uint32_t rec_len;
+static int rec_failed;
+
+static void rec_write(void)
+{
+    if (rec_len && !rec_failed && fs_append(rec_name, rec_buf, rec_len) < 0)
+        rec_failed = 1;
+    rec_len = 0;
+}
+
+static void rec_put(uint8_t b)
+{
+    rec_buf[rec_len++] = b;
+    stats.bytes++;
+    if (rec_len == FBREC_CHUNK)
+        rec_write();
+}
+
+static void rec_frame(const uint8_t *fb)
+{
+    const uint8_t *prev = rec_prev;
+    int i = 0;
+    while (i < FB_SIZE) {
+        if (fb[i] == prev[i]) {
+            int n = 1;
+            while (i + n < FB_SIZE && fb[i + n] == prev[i + n]) n++;
+            if (i + n == FB_SIZE)
+                break;                  /* covered by the end token */
+            i += n;
+            while (n > 127) { rec_put(0x80 | 127); n -= 127; }
+            rec_put((uint8_t)(0x80 | n));
+            continue;
+        }
+
+        int n = 1;
+        while (i + n < FB_SIZE && n < 127) {
+            if (fb[i + n] == prev[i + n] &&
+                (i + n + 1 == FB_SIZE || fb[i + n + 1] == prev[i + n + 1]))
+                break;
+            n++;
+        }
+        rec_put((uint8_t)n);
+        for (int k = 0; k < n; k++)
+            rec_put(fb[i + k] ^ prev[i + k]);
+        i += n;
+    }
+    rec_put(0);
+
+    ets_memcpy(rec_prev, fb, FB_SIZE);
+    stats.frames++;
+
+    if (rec_failed) {
+        fb_set_flush_hook(nullptr);
+        uart_puts("rec: write failed, recording stopped\n");
+    }
+}
+
+int fbrec_start(const char *name, uint16_t fps)
+{
+    if (rec_mem || fps == 0 || !fs_mounted())
+        return -1;
+
+    rec_mem = (uint8_t *)heap_alloc(FB_SIZE + FBREC_CHUNK);
+    if (!rec_mem)
+        return -1;
+    rec_prev = rec_mem;
+    rec_buf = rec_mem + FB_SIZE;
+    ets_memset(rec_prev, 0, FB_SIZE);
+    rec_len = 0;
+    rec_failed = 0;
+
+    fbrec_header_t h;
+    h.magic = FBREC_MAGIC;
+    h.fps = fps;
+    h.frame_bytes = FB_SIZE;
+    fs_delete(name);
+    if (fs_create(name, &h, sizeof(h)) < 0) {
+        heap_free(rec_mem);
+        rec_mem = nullptr;
+        return -1;
+    }
+    ets_strncpy(rec_name, name, FS_PATH_LEN - 1);
+    rec_name[FS_PATH_LEN - 1] = '\0';
+
+    ets_memset(&stats, 0, sizeof(stats));
+    fb_set_flush_hook(rec_frame);
+    return 0;
+}
+
+int fbrec_stop(void)
+{
+    if (!rec_mem)
+        return -1;
+
+    fb_set_flush_hook(nullptr);
+    rec_write();
+    int failed = rec_failed;
+
+    heap_free(rec_mem);
+    rec_mem = nullptr;
+    return failed ? -1 : (int)stats.frames;
+}
+
+int fbrec_active(void)
+{
+    return rec_mem != nullptr && !rec_failed;
+}
+
+/* ====== Player ====== */
+
+#define PLAY_BUF    64
+
+typedef struct {
+    fs_file_t f;
+    uint8_t buf[PLAY_BUF] __attribute__((aligned(4)));
+    uint32_t pos;
+    uint32_t len;
+} player_t;
+
+static int next_byte(player_t *p)
+{
+    if (p->pos == p->len) {
+        int n = fs_fread(&p->f, p->buf, PLAY_BUF);
+        if (n <= 0)
+            return -1;
+        p->len = (uint32_t)n;
+        p->pos = 0;
+        stats.bytes += (uint32_t)n;
+    }
+    return p->buf[p->pos++];
+}
+
+/* Open the file and check its header. Returns the stored fps or -1. */
+static int play_open(player_t *p, const char *name)
+{
+    fbrec_header_t h;
+    p->pos = p->len = 0;
+    if (fs_open(&p->f, name) < 0 ||
+        fs_fread(&p->f, &h, sizeof(h)) != (int)sizeof(h) ||
+        h.magic != FBREC_MAGIC || h.frame_bytes != FB_SIZE || h.fps == 0)
+        return -1;
+    return h.fps;
+}
+
+/* Apply one frame. Returns 1, 0 at end of file, -1 if malformed. */
+static int play_frame(player_t *p, uint8_t *fb)
+{
+    int t = next_byte(p);
+    if (t < 0)
+        return 0;
+
+    uint32_t pos = 0;
+    while (t != 0) {
+        if (t & 0x80) {
+            pos += t & 0x7F;
+        } else {
+            if (pos + t > FB_SIZE)
+                return -1;
+            for (int k = 0; k < t; k++) {
+                int b = next_byte(p);
+                if (b < 0)
+                    return -1;
+                fb[pos++] ^= (uint8_t)b;
+            }
+        }
+        if (pos > FB_SIZE)
+            return -1;
+        t = next_byte(p);
+        if (t < 0)
+            return -1;
+    }
+    return 1;
+}
+
+int fbrec_play(const char *name, uint16_t fps, int loop)
+{
+    /* The decoder handle is ~400 bytes: keep it off the task stack */
+    ets_memset(&stats, 0, sizeof(stats));
+    player_t *p = (player_t *)heap_alloc(sizeof(player_t));
+    if (!p)
+        return -1;
+
+    int stored = play_open(p, name);
+    if (stored < 0) {
+        heap_free(p);
+        return -1;
+    }
+    if (fps == 0)
+        fps = (uint16_t)stored;
+
+    uint8_t *fb = fb_buffer();
+    fb_clear();
+
+    uint32_t start = get_tick_count();
+    uint32_t pass = 0;
+    int rc = 0;
+    for (;;) {
+        if (uart_rx_available() && uart_getc() == 0x03)
+            break;
+
+        rc = play_frame(p, fb);
+        if (rc < 0)
+            break;
+        if (rc == 0) {
+            /* End of file: rewind, or stop after a single pass */
+            if (!loop || pass == 0 || play_open(p, name) < 0)
+                break;
+            pass = 0;
+            fb_clear();
+            continue;
+        }
+
+        fb_flush();
+        stats.frames++;
+        pass++;
+
+        uint32_t due = start + stats.frames * TICK_HZ / fps;
+        int32_t wait = (int32_t)(due - get_tick_count());
+        if (wait > 0) {
+            task_delay_ticks((uint32_t)wait);
+        } else {
+            if (wait < 0) stats.late++;
+            task_yield();
+        }
+    }
+    stats.ticks = get_tick_count() - start;
+
+    heap_free(p);
+    return rc < 0 ? -1 : (int)stats.frames;
+}
+
+fbrec_stats_t *fbrec_stats(void)
+{
+    return &stats;
+}
+
+/* ====== Shell command ====== */
+
+/* Split "NAME [FPS]": copies NAME, returns FPS (0 if absent) or -1 */
+static int parse_name_fps(const char *p, char *name)
+{
+    while (*p == ' ') p++;
+    int n = 0;
+    while (*p && *p != ' ' && n < FS_PATH_LEN - 1) name[n++] = *p++;
+    name[n] = '\0';
+    while (*p == ' ') p++;
+    if (n == 0)
+        return -1;
+
+    int fps = 0;
+    while (*p >= '0' && *p <= '9')
+        fps = fps * 10 + (*p++ - '0');
+    return (*p == '\0' && fps < 1000) ? fps : -1;
+}
+
+static void print_avg(uint32_t bytes, uint32_t frames)
+{
+    uart_put_dec(bytes);
+    uart_puts(" bytes (");
+    uart_put_dec(frames ? bytes / frames : 0);
+    uart_puts("/frame)");
+}
+
+void cmd_rec(const char *args)
+{
+    char name[FS_PATH_LEN];
+    while (*args == ' ') args++;
+
+    if (ets_strncmp(args, "start", 5) == 0 && (args[5] == ' ' || args[5] == '\0')) {
+        int fps = parse_name_fps(args + 5, name);
+        if (fps < 0) { uart_puts("usage: rec start NAME [FPS]\n"); return; }
+        if (fbrec_start(name, fps ? (uint16_t)fps : FBREC_FPS) < 0) {
+            uart_puts("rec: can't record (busy, no heap or no fs)\n");
+            return;
+        }
+        uart_puts("rec: recording to ");
+        uart_puts(name);
+        uart_puts(", run a demo then 'rec stop'\n");
+        return;
+    }
+
+    if (ets_strcmp(args, "stop") == 0) {
+        if (!rec_mem) { uart_puts("rec: not recording\n"); return; }
+        int n = fbrec_stop();
+        uart_puts(n < 0 ? "rec: write failed after " : "rec: ");
+        uart_put_dec(stats.frames);
+        uart_puts(" frames, ");
+        print_avg(stats.bytes, stats.frames);
+        uart_puts("\n");
+        return;
+    }
+
+    int loop = ets_strncmp(args, "loop ", 5) == 0;
+    if (loop || ets_strncmp(args, "play ", 5) == 0) {
+        int fps = parse_name_fps(args + 5, name);
+        if (fps < 0) { uart_puts("usage: rec play|loop NAME [FPS]\n"); return; }
+        uart_puts("rec: playing (Ctrl+C to stop)\n");
+        int n = fbrec_play(name, (uint16_t)fps, loop);
+        if (n < 0 && stats.frames == 0) {
+            uart_puts("rec: not a recording: ");
+            uart_puts(name);
+            uart_puts("\n");
+            return;
+        }
+        uart_put_dec(stats.frames);
+        uart_puts(" frames in ");
+        uart_put_dec(stats.ticks);
+        uart_puts(" ticks (");
+        uart_put_dec(stats.ticks ? stats.frames * TICK_HZ / stats.ticks : 0);
+        uart_puts(" fps), ");
+        uart_put_dec(stats.late);
+        uart_puts(" late, ");
+        print_avg(stats.bytes, stats.frames);
+        uart_puts(n < 0 ? ", stream corrupt\n" : "\n");
+        return;
+    }
+
+    uart_puts("rec commands:\n");
+    uart_puts("  rec start NAME [FPS] - record fb_flush frames to a file\n");
+    uart_puts("  rec stop             - finish the recording\n");
+    uart_puts("  rec play NAME [FPS]  - play back once (FPS: override)\n");
+    uart_puts("  rec loop NAME [FPS]  - play back until Ctrl+C\n");
+}
+
+} /* extern "C" */
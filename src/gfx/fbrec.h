@@ -0,0 +1,70 @@
+/*
+ * OsitoK - Framebuffer recorder and player
+ *
+ * Records every fb_flush() into an OsitoFS file and plays it back at a
+ * fixed frame rate without running the renderer: attract-mode demos
+ * and a repeatable load for timing the video path.
+ *
+ * File format (little endian):
+ *   header   magic "FBR1" (4), fps (2), frame bytes = FB_SIZE (2)
+ *   frames   one token stream per frame, XOR delta against the
+ *            previous frame (the first against a blank screen):
+ *              0x01..0x7F  n literal bytes follow, XORed into fb
+ *              0x81..0xFF  skip n & 0x7F unchanged bytes
+ *              0x00        end of frame (rest unchanged)
+ *
+ * A static frame costs one byte; a wireframe frame a few hundred.
+ *
+ * Usage:
+ *   fbrec_start("demo.fbr", 10);       // arm, then run elite/shipspin
+ *   fbrec_stop();                      // flush and close
+ *   fbrec_play("demo.fbr", 0, 0);      // replay at the recorded fps
+ */
+#ifndef OSITO_FBREC_H
+#define OSITO_FBREC_H
+
+#include "osito.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FBREC_MAGIC     0x31524246  /* "FBR1" */
+#define FBREC_FPS       10          /* default playback rate */
+#define FBREC_CHUNK     1024        /* bytes buffered per fs_append */
+
+typedef struct {
+    uint32_t frames;            /* frames recorded / played */
+    uint32_t bytes;             /* encoded bytes, header excluded */
+    uint32_t ticks;             /* playback: elapsed ticks */
+    uint32_t late;              /* playback: frames that missed their slot */
+} fbrec_stats_t;
+
+/* Start recording fb_flush() frames to a new file (replaces an old
+ * one). fps is stored for playback. Returns 0, or -1 on error. */
+int fbrec_start(const char *name, uint16_t fps);
+
+/* Stop recording and write out buffered frames. Returns the number
+ * of frames recorded, or -1 if no recording was active or a write
+ * failed. */
+int fbrec_stop(void);
+
+/* Is a recording running? */
+int fbrec_active(void);
+
+/* Play a recording. fps == 0 uses the rate stored in the file;
+ * loop != 0 repeats until Ctrl+C (which also ends a single pass).
+ * Returns frames shown, or -1 if the file is missing or malformed. */
+int fbrec_play(const char *name, uint16_t fps, int loop);
+
+/* Counters of the last recording or playback */
+fbrec_stats_t *fbrec_stats(void);
+
+/* Shell command: rec start|stop|play|loop ... */
+void cmd_rec(const char *args);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OSITO_FBREC_H */
@@ -12,6 +12,14 @@
 
 extern "C" {
 
+/*
+ * Face data for hidden-line removal: outward unit normals in 2.14, and
+ * the two faces each edge lies between (NF: on one face only, as the
+ * engine and port outlines are). Faces are those of each model's
+ * convex hull; the Cobra's gun (20-21) goes with the faces at its base.
+ */
+#define NF WIRE_NO_FACE
+
 /* ====== Cobra Mk III — 28 vertices, 38 edges ====== */
 
 static const vec3_t cobra_verts[28] = {
@@ -53,10 +61,36 @@ static const uint8_t cobra_edges[38 * 2] = {
     22,24,  23,24,  22,23,  25,26,  26,27,  25,27,
 };
 
-const wire_model_t ship_cobra = {
-    cobra_verts, cobra_edges, 28, 38
+static const int16_t cobra_normals[15 * 3] = {
+         0, 14654,  7327,  /*  0 */
+         0,-16044,  3319,  /*  1 */
+      4828, 14989,  4523,  /*  2 */
+      2589,-15843,  3278,  /*  3 */
+     -4828, 14989,  4523,  /*  4 */
+     -2589,-15843,  3278,  /*  5 */
+     -4769, 15102,  4198,  /*  6 */
+      4769, 15102,  4198,  /*  7 */
+     -1850, 16279,     0,  /*  8 */
+      1850, 16279,     0,  /*  9 */
+     -8429, 14049,   -88,  /* 10 */
+     -2644,-15862,  3139,  /* 11 */
+      8429, 14049,   -88,  /* 12 */
+      2644,-15862,  3139,  /* 13 */
+         0,     0,-16384,  /* 14 */
 };
 
+static const uint8_t cobra_faces[38 * 2] = {
+     0, 1,   2, 3,   4, 5,  10,11,  12,13,  12,14,   9,14,   8,14,
+    10,14,   6, 8,   7, 9,   6,10,   7,12,   0, 4,   0, 2,  11,14,
+     1,14,  13,14,   1, 5,   1, 3,   4, 6,   2, 7,   0, 1,  14,NF,
+    14,NF,  14,NF,  14,NF,  14,NF,  14,NF,  14,NF,  14,NF,   8, 9,
+    14,NF,  14,NF,  14,NF,  14,NF,  14,NF,  14,NF,
+};
+
+const wire_model_t ship_cobra =
+    WIRE_MODEL_FACES(cobra_verts, cobra_edges, 28, 38,
+                     cobra_normals, cobra_faces, 15, FIX16_C(1.68));
+
 /* ====== Sidewinder — 10 vertices, 15 edges ====== */
 
 static const vec3_t sidewinder_verts[10] = {
@@ -77,10 +111,25 @@ static const uint8_t sidewinder_edges[15 * 2] = {
     6,7,  7,8,  6,9,  8,9,
 };
 
-const wire_model_t ship_sidewinder = {
-    sidewinder_verts, sidewinder_edges, 10, 15
+static const int16_t sidewinder_normals[7 * 3] = {
+         0, 15895,  3974,  /*  0 */
+         0,-15895,  3974,  /*  1 */
+     -3945, 15779,  1972,  /*  2 */
+     -3945,-15779,  1972,  /*  3 */
+      3945, 15779,  1972,  /*  4 */
+      3945,-15779,  1972,  /*  5 */
+         0,     0,-16384,  /*  6 */
 };
 
+static const uint8_t sidewinder_faces[15 * 2] = {
+     0, 1,   4, 5,   0, 4,   0, 2,   2, 3,   2, 6,   4, 6,   3, 6,
+     5, 6,   1, 5,   1, 3,   6,NF,   6,NF,   6,NF,   6,NF,
+};
+
+const wire_model_t ship_sidewinder =
+    WIRE_MODEL_FACES(sidewinder_verts, sidewinder_edges, 10, 15,
+                     sidewinder_normals, sidewinder_faces, 7, FIX16_C(0.874));
+
 /* ====== Viper — 15 vertices, 20 edges ====== */
 
 static const vec3_t viper_verts[15] = {
@@ -106,10 +155,26 @@ static const uint8_t viper_edges[20 * 2] = {
     4,8,  4,6,  3,7,  3,5,  9,12,  9,13,  10,11,  10,14,  11,14,  12,13,
 };
 
-const wire_model_t ship_viper = {
-    viper_verts, viper_edges, 15, 20
+static const int16_t viper_normals[7 * 3] = {
+      8758, 13136,  4379,  /*  0 */
+     -8758, 13136,  4379,  /*  1 */
+      8758,-13136,  4379,  /*  2 */
+     -8758,-13136,  4379,  /*  3 */
+         0, 16384,     0,  /*  4 */
+         0,-16384,     0,  /*  5 */
+         0,     0,-16384,  /*  6 */
+};
+
+static const uint8_t viper_faces[20 * 2] = {
+     0, 2,   0, 1,   2, 3,   1, 3,   0, 4,   1, 4,   2, 5,   3, 5,
+     4, 6,   5, 6,   1, 6,   3, 6,   0, 6,   2, 6,   6,NF,   6,NF,
+     6,NF,   6,NF,   6,NF,   6,NF,
 };
 
+const wire_model_t ship_viper =
+    WIRE_MODEL_FACES(viper_verts, viper_edges, 15, 20,
+                     viper_normals, viper_faces, 7, FIX16_C(0.9));
+
 /* ====== Coriolis Station — 16 vertices, 28 edges ====== */
 
 static const vec3_t coriolis_verts[16] = {
@@ -139,10 +204,34 @@ static const uint8_t coriolis_edges[28 * 2] = {
     /* Docking port */ 12,13,  13,14,  14,15,  15,12,
 };
 
-const wire_model_t ship_coriolis = {
-    coriolis_verts, coriolis_edges, 16, 28
+static const int16_t coriolis_normals[14 * 3] = {
+         0,     0, 16384,  /*  0 */
+      9459,  9459,  9459,  /*  1 */
+      9459, -9459,  9459,  /*  2 */
+     16384,     0,     0,  /*  3 */
+     -9459,  9459,  9459,  /*  4 */
+         0, 16384,     0,  /*  5 */
+     -9459, -9459,  9459,  /*  6 */
+    -16384,     0,     0,  /*  7 */
+         0,-16384,     0,  /*  8 */
+      9459, -9459, -9459,  /*  9 */
+      9459,  9459, -9459,  /* 10 */
+     -9459,  9459, -9459,  /* 11 */
+     -9459, -9459, -9459,  /* 12 */
+         0,     0,-16384,  /* 13 */
+};
+
+static const uint8_t coriolis_faces[28 * 2] = {
+     0, 2,   0, 1,   0, 4,   0, 6,   2, 8,   2, 3,   1, 3,   1, 5,
+     4, 5,   4, 7,   6, 7,   6, 8,   9,13,  10,13,  11,13,  12,13,
+     8, 9,   3, 9,   3,10,   5,10,   5,11,   7,11,   7,12,   8,12,
+     0,NF,   0,NF,   0,NF,   0,NF,
 };
 
+const wire_model_t ship_coriolis =
+    WIRE_MODEL_FACES(coriolis_verts, coriolis_edges, 16, 28,
+                     coriolis_normals, coriolis_faces, 14, FIX16_C(2.829));
+
 /* ====== Ship list ====== */
 
 const wire_model_t *ship_list[SHIP_COUNT] = {
@@ -240,8 +329,8 @@ void cmd_shipspin(void)
         fix16_t z = (s == 3) ? FIX16(8) : FIX16(4);
         vec3_t pos = vec3(0, 0, z);
 
-        angle_t ay = 0;
-        angle_t ax = 0;
+        orient_t spin;
+        orient_init(&spin, nullptr);
         int stop = 0;
 
         for (int f = 0; f < 100; f++) {
@@ -251,18 +340,15 @@ void cmd_shipspin(void)
                 if (ch == 0x03) { stop = 1; break; }
             }
 
-            mat3_t rx, ry, rot;
-            mat3_rotate_x(&rx, ax);
-            mat3_rotate_y(&ry, ay);
-            mat3_multiply(&rot, &ry, &rx);
-
-            fb_clear();
-            wire_render(m, &rot, pos, FIX16(64));
+            if (f < 2 || fb_erase() < 0)
+                fb_clear();
+            fb_set_rop(FB_ROP_XOR);
+            wire_render(m, &spin.m, pos, FIX16(64));
             fb_text_puts(0, 0, ship_names[s]);
-            fb_flush();
+            fb_set_rop(FB_ROP_OR);
+            fb_swap();
 
-            ay += 3;
-            ax += 1;
+            orient_turn(&spin, ANGLE16(1), ANGLE16(3), 0);
             task_yield();
         }
 
@@ -14,30 +14,183 @@ extern "C" {
 
 /* ====== Render pipeline ====== */
 
+/* Vertices per batch transform (three fix16 arrays on the stack) */
+#define WIRE_BATCH      16
+
+/* Vertex i in fix16, from either vertex format */
+static inline vec3_t model_vert(const wire_model_t *m, int i)
+{
+    if (m->verts)
+        return m->verts[i];
+    const int16_t *v = m->verts88 + i * 3;
+    return vec3(v[0] * 256, v[1] * 256, v[2] * 256);
+}
+
+/*
+ * Does face f face the camera? cam is the model's position relative
+ * to the camera, turned into model space (R^T pos), so the test needs
+ * no rotated normals: the face is seen when the normal points against
+ * the ray to one of its vertices, n . (v + cam) < 0. Terms are cut to
+ * 8 fractional bits so the sum fits 32 bits within +-128 units.
+ */
+static int face_seen(const wire_model_t *m, int f, int vert, vec3_t cam)
+{
+    vec3_t w = vec3_add(model_vert(m, vert), cam);
+    const int16_t *n = m->normals + f * 3;
+    int32_t d = (w.x >> 8) * n[0] + (w.y >> 8) * n[1] + (w.z >> 8) * n[2];
+    return d < 0;
+}
+
+/* Vertex i in world space, by the same batch kernel as the rest */
+static vec3_t to_world(const wire_model_t *m, int i,
+                       const mat3_14_t *rot, vec3_t pos)
+{
+    uint8_t k = (uint8_t)i;
+    vec3_t w;
+    mat3_transform_batch(rot, pos, m->verts, m->verts88, &k, 1, &w.x, &w.y, &w.z);
+    return w;
+}
+
+/*
+ * Could any of the bounding sphere be on screen? Tests the near plane
+ * and the four sides of the view (x = +-kx z, y = +-ky z): a side
+ * rejects when the centre is more than r outside it. The distance to
+ * a side is (|x| - k z) / sqrt(1 + k^2); r (1 + k) stands in for
+ * r sqrt(1 + k^2), which only errs towards drawing.
+ */
+static int sphere_visible(vec3_t c, fix16_t r, fix16_t focal)
+{
+    if (c.z + r <= WIRE_NEAR_Z)
+        return 0;
+
+    /* fix_div_fast is within 1/10000 + 2 ulp: widen each side by more
+     * than that, so the slopes can only err towards drawing too */
+    fix16_t kx = fix_div_fast(FIX16(FB_WIDTH / 2), focal);
+    fix16_t ky = fix_div_fast(FIX16(FB_HEIGHT / 2), focal);
+    kx += (kx >> 12) + 2;
+    ky += (ky >> 12) + 2;
+    fix16_t ax = c.x < 0 ? -c.x : c.x;
+    fix16_t ay = c.y < 0 ? -c.y : c.y;
+    if (ax - fix_mul(kx, c.z) > r + fix_mul(r, kx))
+        return 0;
+    if (ay - fix_mul(ky, c.z) > r + fix_mul(r, ky))
+        return 0;
+    return 1;
+}
+
+/* Where a-b crosses the near plane (a in front, b behind), on screen */
+static void near_point(vec3_t a, vec3_t b, fix16_t focal, int *sx, int *sy)
+{
+    fix16_t t = fix_div_fast(a.z - WIRE_NEAR_Z, a.z - b.z);
+    fix16_t x = a.x + fix_mul_fast(b.x - a.x, t);
+    fix16_t y = a.y + fix_mul_fast(b.y - a.y, t);
+    fix16_t inv_z = focal << WIRE_NEAR_SHIFT;   /* focal / WIRE_NEAR_Z */
+    *sx = 64 + FIX16_ROUND(fix_mul_fast(x, inv_z));
+    *sy = 32 - FIX16_ROUND(fix_mul_fast(y, inv_z));
+}
+
 void wire_render(const wire_model_t *model, const mat3_t *rot,
                  vec3_t pos, fix16_t focal)
 {
+    /* Whole model off screen: nothing to transform */
+    if (model->radius && !sphere_visible(pos, model->radius, focal))
+        return;
+
     uint8_t nv = model->nv;
     if (nv > WIRE_MAX_VERTS)
         nv = WIRE_MAX_VERTS;
 
     /* Stack buffers for projected 2D coordinates */
-    int sx[WIRE_MAX_VERTS];
-    int sy[WIRE_MAX_VERTS];
-    uint8_t visible[WIRE_MAX_VERTS];
-
-    /* Transform + project each vertex once */
-    for (int i = 0; i < nv; i++) {
-        vec3_t world = vec3_add(mat3_transform(rot, model->verts[i]), pos);
-        visible[i] = (uint8_t)project(world, focal, &sx[i], &sy[i]);
+    int16_t sx[WIRE_MAX_VERTS];
+    int16_t sy[WIRE_MAX_VERTS];
+    uint8_t state[WIRE_MAX_VERTS];      /* 1 = on a drawn edge, 2 = in front of near plane */
+    uint32_t edge_on[8] = { 0 };        /* edges to draw, one bit each */
+
+    /* Hidden-line removal, as in BBC Elite: an edge is drawn if one of
+     * its faces faces the camera (or it has none). Faces are tested
+     * once, on the first edge that names them. */
+    const uint8_t *ef = model->nf && model->normals ? model->edge_faces : nullptr;
+    uint32_t face_done[8] = { 0 }, face_vis[8] = { 0 };
+    vec3_t cam = vec3(0, 0, 0);
+    if (ef) {
+        const fix16_t (*r)[3] = rot->m;
+        cam = vec3(fix_mul(r[0][0], pos.x) + fix_mul(r[1][0], pos.y) + fix_mul(r[2][0], pos.z),
+                   fix_mul(r[0][1], pos.x) + fix_mul(r[1][1], pos.y) + fix_mul(r[2][1], pos.z),
+                   fix_mul(r[0][2], pos.x) + fix_mul(r[1][2], pos.y) + fix_mul(r[2][2], pos.z));
     }
 
-    /* Draw edges where both endpoints are visible */
+    for (int i = 0; i < nv; i++)
+        state[i] = 0;
+
     for (int i = 0; i < model->ne; i++) {
         uint8_t a = model->edges[i * 2];
         uint8_t b = model->edges[i * 2 + 1];
-        if (a < nv && b < nv && visible[a] && visible[b])
+        if (a >= nv || b >= nv)
+            continue;
+        if (ef) {
+            int faces = 0, seen = 0;
+            for (int k = 0; k < 2; k++) {
+                uint8_t f = ef[i * 2 + k];
+                if (f >= model->nf)
+                    continue;
+                uint32_t bit = 1u << (f & 31);
+                if (!(face_done[f >> 5] & bit)) {
+                    face_done[f >> 5] |= bit;
+                    if (face_seen(model, f, a, cam))
+                        face_vis[f >> 5] |= bit;
+                }
+                faces = 1;
+                if (face_vis[f >> 5] & bit)
+                    seen = 1;
+            }
+            if (faces && !seen)
+                continue;
+        }
+        edge_on[i >> 5] |= 1u << (i & 31);
+        state[a] = state[b] = 1;
+    }
+
+    /* Transform each vertex of a drawn edge once, WIRE_BATCH at a time
+     * through the 2.14 kernel, then project the batch */
+    uint8_t idx[WIRE_MAX_VERTS];
+    int n = 0;
+    for (int i = 0; i < nv; i++)
+        if (state[i])
+            idx[n++] = (uint8_t)i;
+
+    mat3_14_t r14;
+    mat3_to_14(&r14, rot);
+    for (int k = 0; k < n; k += WIRE_BATCH) {
+        fix16_t x[WIRE_BATCH], y[WIRE_BATCH], z[WIRE_BATCH];
+        int c = n - k < WIRE_BATCH ? n - k : WIRE_BATCH;
+        mat3_transform_batch(&r14, pos, model->verts, model->verts88,
+                             idx + k, c, x, y, z);
+        for (int j = 0; j < c; j++) {
+            int i = idx[k + j], px, py;
+            if (project(vec3(x[j], y[j], z[j]), focal, &px, &py)) {
+                sx[i] = (int16_t)px;
+                sy[i] = (int16_t)py;
+                state[i] = 2;
+            }
+        }
+    }
+
+    /* Draw edges, cut at the near plane where they cross it. Those
+     * are rare, so their ends are transformed again rather than kept. */
+    for (int i = 0; i < model->ne; i++) {
+        if (!(edge_on[i >> 5] & (1u << (i & 31))))
+            continue;
+        uint8_t a = model->edges[i * 2];
+        uint8_t b = model->edges[i * 2 + 1];
+        if (state[a] == 2 && state[b] == 2) {
             fb_line(sx[a], sy[a], sx[b], sy[b]);
+        } else if (state[a] == 2 || state[b] == 2) {
+            if (state[b] == 2) { uint8_t t = a; a = b; b = t; }
+            int cx, cy;
+            near_point(to_world(model, a, &r14, pos), to_world(model, b, &r14, pos),
+                       focal, &cx, &cy);
+            fb_line(sx[a], sy[a], cx, cy);
+        }
     }
 }
 
@@ -70,10 +223,27 @@ static const uint8_t cube_edges[12 * 2] = {
     /* Connectors */   0,4,  1,5,  2,6,  3,7,
 };
 
-const wire_model_t wire_cube = {
-    cube_verts, cube_edges, 8, 12
+/* Outward unit normals, 2.14 */
+static const int16_t cube_normals[6 * 3] = {
+         0,     0,-16384,  /* 0: front  0 1 2 3 */
+         0,     0, 16384,  /* 1: back   4 5 6 7 */
+         0,-16384,     0,  /* 2: bottom 0 1 5 4 */
+         0, 16384,     0,  /* 3: top    3 2 6 7 */
+    -16384,     0,     0,  /* 4: left   0 3 7 4 */
+     16384,     0,     0,  /* 5: right  1 2 6 5 */
 };
 
+/* The two faces of each edge */
+static const uint8_t cube_faces[12 * 2] = {
+    0,2,  0,5,  0,3,  0,4,
+    1,2,  1,5,  1,3,  1,4,
+    2,4,  2,5,  3,5,  3,4,
+};
+
+const wire_model_t wire_cube =
+    WIRE_MODEL_FACES(cube_verts, cube_edges, 8, 12, cube_normals, cube_faces, 6,
+                     FIX16_C(1.733));
+
 /* ====== Test: static cube ====== */
 
 void wire_test(void)
@@ -99,8 +269,8 @@ void wire_spin(void)
     uart_puts("wirespin: spinning cube (Ctrl+C to stop)\n");
 
     vec3_t pos = vec3(0, 0, FIX16(5));
-    angle_t ay = 0;
-    angle_t ax = 0;
+    orient_t spin;
+    orient_init(&spin, nullptr);
     uint32_t frames = 0;
     uint32_t t_start = get_tick_count();
 
@@ -112,18 +282,15 @@ void wire_spin(void)
                 break;
         }
 
-        /* Build combined rotation: X then Y */
-        mat3_t rx, ry, rot;
-        mat3_rotate_x(&rx, ax);
-        mat3_rotate_y(&ry, ay);
-        mat3_multiply(&rot, &ry, &rx);
-
-        fb_clear();
-        wire_render(&wire_cube, &rot, pos, FIX16(64));
-        fb_flush();
+        /* Erase by redrawing last frame's cube (first frame per buffer clears) */
+        if (frames < 2 || fb_erase() < 0)
+            fb_clear();
+        fb_set_rop(FB_ROP_XOR);
+        wire_render(&wire_cube, &spin.m, pos, FIX16(64));
+        fb_set_rop(FB_ROP_OR);
+        fb_swap();
 
-        ay += 3;  /* ~4.2° per frame */
-        ax += 1;  /* ~1.4° per frame */
+        orient_turn(&spin, ANGLE16(1), ANGLE16(3), 0);  /* ~1.4°, ~4.2° per frame */
         frames++;
 
         task_yield();
@@ -18,20 +18,50 @@ extern "C" {
 /* Maximum vertices per model (for stack-allocated projection buffers) */
 #define WIRE_MAX_VERTS  64
 
-/* Wireframe model: vertex array + edge index pairs */
+/* Wireframe model: vertex array + edge index pairs.
+ * Built-in models use fix16 vertices; models loaded from files
+ * (wmodel.h) point verts88 at their 8.8 data instead. */
 typedef struct {
-    const vec3_t  *verts;    /* array of 3D vertices */
+    const vec3_t  *verts;    /* array of 3D vertices, or null */
     const uint8_t *edges;    /* pairs of vertex indices [a,b, a,b, ...] */
     uint8_t        nv;       /* number of vertices (max WIRE_MAX_VERTS) */
     uint8_t        ne;       /* number of edges */
+    uint8_t        nf;       /* number of faces (0 = no face data) */
+    const int16_t *verts88;  /* 8.8 vertices [x,y,z, ...] when verts is null */
+    const int16_t *normals;  /* face normals [x,y,z, ...] in 2.14, or null */
+    const uint8_t *edge_faces; /* two face indices per edge (0xFF = none) */
+    fix16_t        radius;   /* bounding sphere radius, 0 = unknown */
 } wire_model_t;
 
+#define WIRE_NO_FACE    0xFF    /* edge_faces entry: no face */
+
+/* Initializer for a built-in model without face data */
+#define WIRE_MODEL(verts, edges, nv, ne) \
+    { verts, edges, nv, ne, 0, nullptr, nullptr, nullptr, 0 }
+
+/* ... and with it: nf normals, two faces per edge, bounding radius */
+#define WIRE_MODEL_FACES(verts, edges, nv, ne, normals, faces, nf, radius) \
+    { verts, edges, nv, ne, nf, nullptr, normals, faces, radius }
+
+/* Near plane: nearer points are behind the camera for project().
+ * A power of two, so dividing by it is a shift. */
+#define WIRE_NEAR_SHIFT 1
+#define WIRE_NEAR_Z     (FIX16_ONE >> WIRE_NEAR_SHIFT)
+
 /*
  * Render wireframe model to framebuffer.
  * rot:   3x3 rotation matrix (object orientation)
  * pos:   object position in world space (camera at origin)
  * focal: focal length for perspective (typical: FIX16(64))
  *
+ * A model whose bounding sphere (radius, if known) is out of view is
+ * skipped before any vertex is transformed. With face data, edges
+ * whose faces all point away from the camera are skipped (hidden-line
+ * removal for convex models), and so are vertices on no drawn edge.
+ * Edges crossing the near plane are cut there. Vertices are rotated
+ * in batches by mat3_transform_batch(), so fix16 vertices must lie
+ * within +-8 units.
+ *
  * Does NOT call fb_clear or fb_flush — caller controls those.
  */
 void wire_render(const wire_model_t *model, const mat3_t *rot,
@@ -0,0 +1,245 @@
+/*
+ * OsitoK - Wireframe models loaded from OsitoFS
+ *
+ * Each loaded model is one heap block holding the file image; its
+ * wire_model_t points into the block. Models are validated once at
+ * load so the renderer can trust the indices.
+ */
+
+#include "gfx/wmodel.h"
+#include "gfx/ships.h"
+#include "drivers/video.h"
+#include "drivers/uart.h"
+#include "fs/ositofs.h"
+#include "mem/heap.h"
+
+extern "C" {
+
+typedef struct {
+    wire_model_t m;
+    void *mem;                  /* heap block with the file image */
+    char name[FS_NAME_LEN];     /* file name without directory/extension */
+} wmodel_slot_t;
+
+static wmodel_slot_t slots[WMODEL_MAX];
+static int loaded = 0;
+
+/* ====== Parsing ====== */
+
+int wmodel_parse(const void *data, uint32_t size, wire_model_t *m)
+{
+    const uint8_t *p = (const uint8_t *)data;
+    wmodel_header_t h;
+    if (size < sizeof(h) || ((uintptr_t)p & 1))
+        return -1;
+    ets_memcpy(&h, p, sizeof(h));
+
+    uint32_t need = sizeof(h) + (uint32_t)h.nv * 6 + (uint32_t)h.nf * 6
+                  + (uint32_t)h.ne * (h.nf ? 4 : 2);
+    if (h.magic != WMODEL_MAGIC || h.nv == 0 || h.nv > WIRE_MAX_VERTS ||
+        size < need)
+        return -1;
+
+    const uint8_t *edges = p + sizeof(h) + (uint32_t)(h.nv + h.nf) * 6;
+    const uint8_t *faces = h.nf ? edges + (uint32_t)h.ne * 2 : nullptr;
+    for (int i = 0; i < h.ne * 2; i++) {
+        if (edges[i] >= h.nv)
+            return -1;
+        if (faces && faces[i] != 0xFF && faces[i] >= h.nf)
+            return -1;
+    }
+
+    m->verts = nullptr;
+    m->edges = edges;
+    m->nv = h.nv;
+    m->ne = h.ne;
+    m->nf = h.nf;
+    m->verts88 = (const int16_t *)(p + sizeof(h));
+    m->normals = h.nf ? m->verts88 + h.nv * 3 : nullptr;
+    m->edge_faces = faces;
+    m->radius = (fix16_t)h.radius << 8;
+    return 0;
+}
+
+/* ====== Registry ====== */
+
+/* "dir/name.ext" -> "name" */
+static void base_name(const char *path, char *name)
+{
+    const char *s = path;
+    for (const char *q = path; *q; q++)
+        if (*q == '/') s = q + 1;
+    int n = 0;
+    while (s[n] && s[n] != '.' && n < FS_NAME_LEN - 1) {
+        name[n] = s[n];
+        n++;
+    }
+    name[n] = '\0';
+}
+
+int wmodel_load(const char *path)
+{
+    char name[FS_NAME_LEN];
+    base_name(path, name);
+
+    int size = fs_stat(path);
+    if (size <= 0)
+        return -1;
+
+    void *mem = heap_alloc((uint32_t)size);
+    if (!mem)
+        return -1;
+
+    wire_model_t m;
+    if (fs_read(path, mem, (uint32_t)size) != size ||
+        wmodel_parse(mem, (uint32_t)size, &m) < 0) {
+        heap_free(mem);
+        return -1;
+    }
+
+    /* Same name replaces, otherwise take the next free slot */
+    int i = 0;
+    while (i < loaded && ets_strcmp(slots[i].name, name) != 0) i++;
+    if (i == WMODEL_MAX) {
+        heap_free(mem);
+        return -1;
+    }
+    if (i < loaded)
+        heap_free(slots[i].mem);
+    else
+        loaded++;
+
+    slots[i].m = m;
+    slots[i].mem = mem;
+    ets_memcpy(slots[i].name, name, FS_NAME_LEN);
+    return 1 + SHIP_COUNT + i;
+}
+
+void wmodel_unload_all(void)
+{
+    for (int i = 0; i < loaded; i++)
+        heap_free(slots[i].mem);
+    loaded = 0;
+}
+
+int wmodel_total(void)
+{
+    return 1 + SHIP_COUNT + loaded;
+}
+
+const wire_model_t *wmodel_at(int idx)
+{
+    if (idx == 0)
+        return &wire_cube;
+    if (idx >= 1 && idx <= SHIP_COUNT)
+        return ship_list[idx - 1];
+    idx -= 1 + SHIP_COUNT;
+    return (idx >= 0 && idx < loaded) ? &slots[idx].m : nullptr;
+}
+
+const char *wmodel_name_at(int idx)
+{
+    if (idx == 0)
+        return "cube";
+    if (idx >= 1 && idx <= SHIP_COUNT)
+        return ship_names[idx - 1];
+    idx -= 1 + SHIP_COUNT;
+    return (idx >= 0 && idx < loaded) ? slots[idx].name : nullptr;
+}
+
+/* ====== Shell: model ====== */
+
+static void show_model(int idx)
+{
+    const wire_model_t *m = wmodel_at(idx);
+
+    /* Back off far enough for the bounding sphere to fit */
+    fix16_t z = FIX16(4);
+    if (m->radius * 2 > z)
+        z = m->radius * 2;
+
+    mat3_t rx, ry, rot;
+    mat3_rotate_x(&rx, 20);
+    mat3_rotate_y(&ry, 200);
+    mat3_multiply(&rot, &ry, &rx);
+
+    fb_clear();
+    wire_render(m, &rot, vec3(0, 0, z), FIX16(64));
+    fb_text_puts(0, 0, wmodel_name_at(idx));
+    fb_flush();
+}
+
+void cmd_model(const char *args)
+{
+    while (*args == ' ') args++;
+
+    if (ets_strncmp(args, "load ", 5) == 0) {
+        const char *path = args + 5;
+        while (*path == ' ') path++;
+        int idx = wmodel_load(path);
+        if (idx < 0) {
+            uart_puts("model: can't load ");
+            uart_puts(path);
+            uart_puts(" (missing, malformed, no heap or ");
+            uart_put_dec(WMODEL_MAX);
+            uart_puts(" loaded)\n");
+            return;
+        }
+        uart_puts("model ");
+        uart_put_dec(idx);
+        uart_puts(": ");
+        uart_puts(wmodel_name_at(idx));
+        uart_puts("\n");
+        return;
+    }
+
+    if (ets_strcmp(args, "free") == 0) {
+        wmodel_unload_all();
+        return;
+    }
+
+    if (ets_strncmp(args, "show ", 5) == 0) {
+        const char *p = args + 5;
+        int idx = 0;
+        while (*p >= '0' && *p <= '9')
+            idx = idx * 10 + (*p++ - '0');
+        if (!wmodel_at(idx)) {
+            uart_puts("model: no such index\n");
+            return;
+        }
+        show_model(idx);
+        return;
+    }
+
+    if (*args != '\0') {
+        uart_puts("usage: model [load PATH | show N | free]\n");
+        return;
+    }
+
+    /* List every model */
+    uart_puts(" #  Name           V   E   F  Radius\n");
+    for (int i = 0; i < wmodel_total(); i++) {
+        const wire_model_t *m = wmodel_at(i);
+        const char *name = wmodel_name_at(i);
+        uart_puts(i < 10 ? "  " : " ");
+        uart_put_dec(i);
+        uart_putc(' ');
+        int len = 0;
+        while (name[len]) uart_putc(name[len++]);
+        for (; len < 12; len++) uart_putc(' ');
+        uart_puts(m->nv < 10 ? "   " : "  ");
+        uart_put_dec(m->nv);
+        uart_puts(m->ne < 10 ? "   " : "  ");
+        uart_put_dec(m->ne);
+        uart_puts(m->nf < 10 ? "   " : "  ");
+        uart_put_dec(m->nf);
+        uart_puts("  ");
+        if (m->radius)
+            fix_print(m->radius);
+        else
+            uart_putc('-');
+        uart_puts(i > SHIP_COUNT ? "  (file)\n" : "\n");
+    }
+}
+
+} /* extern "C" */
@@ -0,0 +1,72 @@
+/*
+ * OsitoK - Wireframe models loaded from OsitoFS
+ *
+ * Binary model file (little endian, built by tools/wmodel.py):
+ *   header      magic "OWM1" (4), nv, ne, nf, flags (1 each),
+ *               bounding radius 8.8 (2), reserved (2)      12 bytes
+ *   verts       nv x (x, y, z) int16 8.8                   6 * nv
+ *   normals     nf x (x, y, z) int16 2.14 unit vectors     6 * nf
+ *   edges       ne x (a, b) vertex indices                 2 * ne
+ *   edge faces  ne x (f0, f1) face indices, 0xFF = none    2 * ne (nf > 0)
+ *
+ * A file is read into one heap block and the wire_model_t points into
+ * it, so the renderer draws the 8.8 data in place. Without faces the
+ * Cobra (28 vertices, 38 edges) takes 256 bytes, against 412 for the
+ * built-in vertices and edges.
+ *
+ * Loaded models follow the built-in ones in a single index space:
+ * 0 = cube, 1..SHIP_COUNT = ships, then files in load order. The shell
+ * ('model'), Forth (wire-render, model-load) and the game use it.
+ *
+ * Usage:
+ *   int idx = wmodel_load("models/thargoid.owm");
+ *   wire_render(wmodel_at(idx), &rot, pos, FIX16(64));
+ */
+#ifndef OSITO_WMODEL_H
+#define OSITO_WMODEL_H
+
+#include "gfx/wire3d.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define WMODEL_MAGIC    0x314D574F  /* "OWM1" */
+#define WMODEL_MAX      4           /* models loaded at once */
+
+typedef struct {
+    uint32_t magic;
+    uint8_t  nv;
+    uint8_t  ne;
+    uint8_t  nf;
+    uint8_t  flags;             /* 0, reserved */
+    uint16_t radius;            /* 8.8 */
+    uint16_t reserved;
+} wmodel_header_t;
+
+/* Check a model image and point m at the data inside it (no copy).
+ * Returns 0, or -1 if the image is malformed. */
+int wmodel_parse(const void *data, uint32_t size, wire_model_t *m);
+
+/* Load a model file into the heap (replacing one loaded under the same
+ * name). Returns its index for wmodel_at(), or -1 on error. */
+int wmodel_load(const char *path);
+
+/* Release every loaded model */
+void wmodel_unload_all(void);
+
+/* Number of models, built-in and loaded */
+int wmodel_total(void);
+
+/* Model / name by index, nullptr if out of range */
+const wire_model_t *wmodel_at(int idx);
+const char *wmodel_name_at(int idx);
+
+/* Shell command: model [load PATH | show N | free] */
+void cmd_model(const char *args);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OSITO_WMODEL_H */
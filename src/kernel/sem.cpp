@@ -1,5 +1,5 @@
 /*
- * OsitoK - Counting semaphores and mutexes
+ * OsitoK - Counting semaphores, mutexes and reader-writer locks
  *
  * Semaphore wait queue is a simple FIFO array (MAX_TASKS = 8,
  * so no need for linked lists). Tasks that block go to
@@ -113,4 +113,49 @@ void mutex_unlock(mutex_t *m)
     sem_post(&m->sem);
 }
 
+/* ====== Reader-Writer Lock ====== */
+
+void rwlock_init(rwlock_t *rw)
+{
+    mutex_init(&rw->turnstile);
+    mutex_init(&rw->count_lock);
+    sem_init(&rw->room_empty, 1);
+    rw->readers = 0;
+}
+
+void rwlock_read_lock(rwlock_t *rw)
+{
+    /* Pass through the turnstile: blocks if a writer is queued */
+    mutex_lock(&rw->turnstile);
+    mutex_unlock(&rw->turnstile);
+
+    /* First reader in locks writers out */
+    mutex_lock(&rw->count_lock);
+    if (++rw->readers == 1)
+        sem_wait(&rw->room_empty);
+    mutex_unlock(&rw->count_lock);
+}
+
+void rwlock_read_unlock(rwlock_t *rw)
+{
+    /* Last reader out lets writers in */
+    mutex_lock(&rw->count_lock);
+    if (--rw->readers == 0)
+        sem_post(&rw->room_empty);
+    mutex_unlock(&rw->count_lock);
+}
+
+void rwlock_write_lock(rwlock_t *rw)
+{
+    /* Keep the turnstile closed until done, so no new readers enter */
+    mutex_lock(&rw->turnstile);
+    sem_wait(&rw->room_empty);
+}
+
+void rwlock_write_unlock(rwlock_t *rw)
+{
+    sem_post(&rw->room_empty);
+    mutex_unlock(&rw->turnstile);
+}
+
 } /* extern "C" */
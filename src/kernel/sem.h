@@ -1,8 +1,9 @@
 /*
- * OsitoK - Counting semaphores and mutexes
+ * OsitoK - Counting semaphores, mutexes and reader-writer locks
  *
- * sem_t:   Counting semaphore with FIFO wait queue.
- * mutex_t: Binary mutex (sem initialized to 1).
+ * sem_t:    Counting semaphore with FIFO wait queue.
+ * mutex_t:  Binary mutex (sem initialized to 1).
+ * rwlock_t: Reader-writer lock (many readers or one writer).
  *
  * All operations are safe to call from task context.
  * Do NOT call from ISR context (they may yield).
@@ -57,6 +58,32 @@ int mutex_trylock(mutex_t *m);
 /* Release mutex. Wakes one waiting task if any. */
 void mutex_unlock(mutex_t *m);
 
+/* ====== Reader-Writer Lock ====== */
+
+/*
+ * Any number of readers, or one writer. A waiting writer closes the
+ * turnstile, so readers arriving after it queue behind it instead of
+ * starving it. Not recursive: a task holding the lock must not take it
+ * again (a writer queued in between would deadlock it).
+ */
+typedef struct {
+    mutex_t  turnstile;                 /* held by a waiting/active writer */
+    mutex_t  count_lock;                /* protects readers */
+    sem_t    room_empty;                /* 1 when nobody holds the lock */
+    int32_t  readers;
+} rwlock_t;
+
+/* Initialize reader-writer lock (unlocked) */
+void rwlock_init(rwlock_t *rw);
+
+/* Shared access. Blocks while a writer holds or waits for the lock. */
+void rwlock_read_lock(rwlock_t *rw);
+void rwlock_read_unlock(rwlock_t *rw);
+
+/* Exclusive access. Blocks until all readers have left. */
+void rwlock_write_lock(rwlock_t *rw);
+void rwlock_write_unlock(rwlock_t *rw);
+
 #ifdef __cplusplus
 }
 #endif
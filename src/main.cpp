@@ -15,6 +15,8 @@
 #include "mem/pool_alloc.h"
 #include "mem/heap.h"
 #include "fs/ositofs.h"
+#include "fs/fcache.h"
+#include "fs/flashio.h"
 #include "kernel/task.h"
 #include "drivers/input.h"
 #include "drivers/video.h"
@@ -38,6 +40,14 @@ void kernel_main(void)
     pool_init();
     heap_init();
 
+    /* Flash I/O queue and bus lock; requests run inline until the
+     * flash task starts */
+    flashio_init();
+
+    /* Flash read cache comes out of the heap (off unless FS_CACHE_BYTES
+     * is set); mount after it is sized */
+    fcache_config(FS_CACHE_BYTES, FS_CACHE_PAGE);
+
     /* Mount filesystem (non-fatal if not formatted yet) */
     fs_init();
 
@@ -53,6 +63,7 @@ void kernel_main(void)
     /* Create user tasks (higher priority = runs first) */
     task_create("input", input_task, nullptr, 2);
     task_create("shell", shell_task, nullptr, 3);
+    task_create("flashio", flashio_task, nullptr, 3);  /* round-robin with shell */
 
     /* Configure FRC1 timer for 100Hz preemptive ticks */
     timer_init();
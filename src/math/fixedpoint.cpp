@@ -1,66 +1,94 @@
 /*
  * OsitoK - Fixed-point 16.16 math library (non-inline functions)
  *
- * Contains: sine table, fix_div, fix_sqrt, fix_print, fix_test
+ * Contains: generated lookup tables, fix_div, fix_recip, fix_sqrt and
+ * their _fast versions, fix_print, fix_test
  */
 
 #include "math/fixedpoint.h"
+#include "math/tables.h"
 #include "drivers/uart.h"
+#include "kernel/config.h"
 
 extern "C" {
 
-/* ====== Sine table: 256 entries, full circle ====== */
+/* ====== Table sizes ====== */
 
 /*
- * sin_table[i] = fix16(sin(i * 2π / 256))
- * Full circle stored (no quarter-wave tricks) for zero-branch lookup.
- * 256 × 4 = 1024 bytes DRAM.
+ * Each table has 1 << bits entries (per unit of [1, 4) for 1/sqrt),
+ * two bytes each, generated at compile time (math/tables.h). Build
+ * with e.g. -DFIX_SIN_BITS=8 to trade DRAM for accuracy; the error
+ * bounds in fixedpoint.h hold for these defaults.
  */
-static const fix16_t sin_table[256] = {
-         0,   1608,   3216,   4821,   6424,   8022,   9616,  11204,
-     12785,  14359,  15924,  17479,  19024,  20557,  22078,  23586,
-     25080,  26558,  28020,  29466,  30893,  32303,  33692,  35062,
-     36410,  37736,  39040,  40320,  41576,  42806,  44011,  45190,
-     46341,  47464,  48559,  49624,  50660,  51665,  52639,  53581,
-     54491,  55368,  56212,  57022,  57798,  58538,  59244,  59914,
-     60547,  61145,  61705,  62228,  62714,  63162,  63572,  63944,
-     64277,  64571,  64827,  65043,  65220,  65358,  65457,  65516,
-     65536,  65516,  65457,  65358,  65220,  65043,  64827,  64571,
-     64277,  63944,  63572,  63162,  62714,  62228,  61705,  61145,
-     60547,  59914,  59244,  58538,  57798,  57022,  56212,  55368,
-     54491,  53581,  52639,  51665,  50660,  49624,  48559,  47464,
-     46341,  45190,  44011,  42806,  41576,  40320,  39040,  37736,
-     36410,  35062,  33692,  32303,  30893,  29466,  28020,  26558,
-     25080,  23586,  22078,  20557,  19024,  17479,  15924,  14359,
-     12785,  11204,   9616,   8022,   6424,   4821,   3216,   1608,
-         0,  -1608,  -3216,  -4821,  -6424,  -8022,  -9616, -11204,
-    -12785, -14359, -15924, -17479, -19024, -20557, -22078, -23586,
-    -25080, -26558, -28020, -29466, -30893, -32303, -33692, -35062,
-    -36410, -37736, -39040, -40320, -41576, -42806, -44011, -45190,
-    -46341, -47464, -48559, -49624, -50660, -51665, -52639, -53581,
-    -54491, -55368, -56212, -57022, -57798, -58538, -59244, -59914,
-    -60547, -61145, -61705, -62228, -62714, -63162, -63572, -63944,
-    -64277, -64571, -64827, -65043, -65220, -65358, -65457, -65516,
-    -65536, -65516, -65457, -65358, -65220, -65043, -64827, -64571,
-    -64277, -63944, -63572, -63162, -62714, -62228, -61705, -61145,
-    -60547, -59914, -59244, -58538, -57798, -57022, -56212, -55368,
-    -54491, -53581, -52639, -51665, -50660, -49624, -48559, -47464,
-    -46341, -45190, -44011, -42806, -41576, -40320, -39040, -37736,
-    -36410, -35062, -33692, -32303, -30893, -29466, -28020, -26558,
-    -25080, -23586, -22078, -20557, -19024, -17479, -15924, -14359,
-    -12785, -11204,  -9616,  -8022,  -6424,  -4821,  -3216,  -1608,
-};
+#ifndef FIX_SIN_BITS
+#define FIX_SIN_BITS    7       /* quarter-wave sine: 128 entries, 256 bytes */
+#endif
+#ifndef FIX_RECIP_BITS
+#define FIX_RECIP_BITS  6       /* reciprocal seeds: 64 entries, 128 bytes */
+#endif
+#ifndef FIX_RSQRT_BITS
+#define FIX_RSQRT_BITS  4       /* 1/sqrt seeds: 48 entries, 96 bytes */
+#endif
+
+static_assert(FIX_SIN_BITS >= 6 && FIX_SIN_BITS <= 13,
+              "angle_t must land on entries; interpolation needs a fraction bit");
+static_assert(FIX_RECIP_BITS >= 1 && FIX_RECIP_BITS <= 15, "FIX_RECIP_BITS out of range");
+static_assert(FIX_RSQRT_BITS >= 1 && FIX_RSQRT_BITS <= 14, "FIX_RSQRT_BITS out of range");
+
+/* ====== Sine table: quarter wave ====== */
+
+/*
+ * quarter_sin[i] = fix16(sin(i * 90° / N)), for 0 <= i < N;
+ * sin(90°) = 1.0 does not fit 16 bits and is supplied by the lookup.
+ * The other three quarters are mirror images of this one.
+ */
+#define SIN_N       (1 << FIX_SIN_BITS)
+#define SIN_FRAC    (14 - FIX_SIN_BITS)     /* angle bits between entries */
+
+static constexpr lut_t<uint16_t, SIN_N> quarter_sin =
+    lut_quarter_sin<uint16_t, SIN_N, FIX16_ONE>();
 
 /* ====== Trigonometry ====== */
 
+/* sin of p / 16384 of a quarter turn, 0 <= p <= 16384: the two table
+ * entries around p, interpolated on p's low SIN_FRAC bits */
+static inline fix16_t quarter_lookup(uint32_t p)
+{
+    int i = (int)(p >> SIN_FRAC);
+    if (i >= SIN_N)
+        return FIX16_ONE;
+    int32_t a = quarter_sin[i];
+    int32_t b = i < SIN_N - 1 ? quarter_sin[i + 1] : FIX16_ONE;
+    int32_t t = (int32_t)(p & ((1 << SIN_FRAC) - 1));
+    return a + (((b - a) * t + (1 << (SIN_FRAC - 1))) >> SIN_FRAC);
+}
+
+fix16_t fix_sin16(angle16_t angle)
+{
+    uint32_t p = angle & 0x3FFF;
+    switch (angle >> 14) {
+    case 0:  return quarter_lookup(p);
+    case 1:  return quarter_lookup(0x4000 - p);
+    case 2:  return -quarter_lookup(p);
+    default: return -quarter_lookup(0x4000 - p);
+    }
+}
+
+fix16_t fix_cos16(angle16_t angle)
+{
+    return fix_sin16((angle16_t)(angle + 0x4000));
+}
+
+/* An angle_t lands on a table entry, so these give the exact
+ * values the old full-circle table held */
 fix16_t fix_sin(angle_t angle)
 {
-    return sin_table[angle];
+    return fix_sin16(ANGLE16(angle));
 }
 
 fix16_t fix_cos(angle_t angle)
 {
-    return sin_table[(uint8_t)(angle + 64)];
+    return fix_sin16(ANGLE16((uint8_t)(angle + 64)));
 }
 
 /* ====== Division ====== */
@@ -77,6 +105,53 @@ fix16_t fix_div(fix16_t a, fix16_t b)
     return (fix16_t)(num / (int64_t)b);
 }
 
+/* ====== Reciprocal ====== */
+
+/*
+ * recip_table[i] = 65536 / (1 + (i + 0.5) / N): 1/f for a mantissa
+ * f in [1, 2) whose top FIX_RECIP_BITS fraction bits are i.
+ */
+#define RECIP_N     (1 << FIX_RECIP_BITS)
+
+static constexpr lut_t<uint16_t, RECIP_N> recip_table =
+    lut_recip<uint16_t, RECIP_N, FIX16_ONE>();
+
+/*
+ * x = f * 2^(15 - s) in fix16, with f = (x << s) as 1.31, so
+ * 1/x = (1/f) * 2^(s - 15). Newton's r += r (1 - f r) squares the
+ * table's error; 1 - f r is small, so r times it needs only its top
+ * bits and every product fits 32 bits.
+ */
+uint32_t fix_recip(fix16_t x, int *shift)
+{
+    int s = __builtin_clz((uint32_t)x);
+    uint32_t m = (uint32_t)x << s;
+    int32_t r = recip_table[(m >> (31 - FIX_RECIP_BITS)) & (RECIP_N - 1)];
+    int32_t e = (int32_t)(0x80000000u - (m >> 16) * (uint32_t)r);  /* 1 - f r, 1.31 */
+    r += (r * (e >> 15)) >> 16;
+    *shift = s - 15;
+    return (uint32_t)r;
+}
+
+/*
+ * a / b = a * r * 2^sh / 2^16 = (a * r) >> (16 - sh), with a split into
+ * 16-bit halves so both products fit 32 bits.
+ */
+fix16_t fix_div_fast(fix16_t a, fix16_t b)
+{
+    if (b == 0) return (a >= 0) ? FIX16_MAX : FIX16_MIN;
+
+    uint32_t ua = a < 0 ? 0u - (uint32_t)a : (uint32_t)a;
+    uint32_t ub = b < 0 ? 0u - (uint32_t)b : (uint32_t)b;
+    int sh;
+    uint32_t r = fix_recip((fix16_t)ub, &sh);
+    int n = 16 - sh;                            /* 0..31 */
+    uint32_t ah = ua >> 16, al = ua & 0xFFFF;
+    uint32_t q = (n <= 16 ? (ah * r) << (16 - n) : (ah * r) >> (n - 16))
+               + ((al * r) >> n);
+    return ((a < 0) != (b < 0)) ? -(fix16_t)q : (fix16_t)q;
+}
+
 /* ====== Square root ====== */
 
 /*
@@ -117,6 +192,38 @@ fix16_t fix_sqrt(fix16_t x)
     return (fix16_t)root;
 }
 
+/*
+ * rsqrt_table[i] = 65536 / sqrt(1 + (i + 0.5) / K): 1/sqrt(f) for
+ * f in [1, 4), K = 1 << FIX_RSQRT_BITS entries per unit.
+ */
+#define RSQRT_K     (1 << FIX_RSQRT_BITS)
+
+static constexpr lut_t<uint16_t, 3 * RSQRT_K> rsqrt_table =
+    lut_rsqrt<uint16_t, RSQRT_K, FIX16_ONE>();
+
+/*
+ * x = f * 2^(30 - s) raw, f in [1, 4) with s even, so
+ * sqrt(x) in fix16 is sqrt(f) * 2^(23 - s/2). Newton's
+ * g += g (1 - f g^2) / 2 refines g = 1/sqrt(f) without dividing,
+ * and sqrt(f) = f g.
+ */
+fix16_t fix_sqrt_fast(fix16_t x)
+{
+    if (x <= 0) return 0;
+
+    int s = __builtin_clz((uint32_t)x) & ~1;
+    uint32_t m = (uint32_t)x << s;              /* f as 2.30 */
+    uint32_t f = m >> 16;                       /* f as 2.14 */
+    int32_t g = rsqrt_table[(m >> (30 - FIX_RSQRT_BITS)) - RSQRT_K];  /* 0.16 */
+
+    for (int i = 0; i < 2; i++) {
+        uint32_t g2 = ((uint32_t)g * (uint32_t)g) >> 16;
+        int32_t e = (int32_t)((1u << 30) - f * g2); /* 1 - f g^2, 2.30 */
+        g += (g * (e >> 14)) >> 17;
+    }
+    return (fix16_t)((f * (uint32_t)g) >> (7 + s / 2));
+}
+
 /* ====== Print ====== */
 
 /*
@@ -148,9 +255,10 @@ void fix_print(fix16_t x)
     uart_put_dec(dec);
 }
 
+#if OSITO_BENCH
 /* ====== Validation test ====== */
 
-static void test_case(const char *label, fix16_t got, fix16_t expected, fix16_t tolerance)
+static void ICACHE_FLASH_ATTR test_case(const char *label, fix16_t got, fix16_t expected, fix16_t tolerance)
 {
     uart_puts(label);
     uart_puts(" = ");
@@ -166,7 +274,100 @@ static void test_case(const char *label, fix16_t got, fix16_t expected, fix16_t
     }
 }
 
-void fix_test(void)
+/*
+ * Exact kernels against their _fast versions over FIX_BENCH_N inputs
+ * spread across the fix16 range: cycles per call, and whether every
+ * difference is within the bound given in fixedpoint.h.
+ */
+#define FIX_BENCH_N  64
+
+static void ICACHE_FLASH_ATTR bench_line(const char *name, uint32_t c_exact, uint32_t c_fast, int ok)
+{
+    uart_puts(name);
+    uart_put_dec(c_exact / FIX_BENCH_N);
+    uart_puts(" -> ");
+    uart_put_dec(c_fast / FIX_BENCH_N);
+    uart_puts(ok ? " cycles  OK\n" : " cycles  FAIL\n");
+}
+
+static void ICACHE_FLASH_ATTR fix_bench(void)
+{
+    fix16_t a[FIX_BENCH_N], b[FIX_BENCH_N], e[FIX_BENCH_N], f[FIX_BENCH_N];
+    uint32_t seed = 1, t0, c_exact, c_fast;
+    int ok;
+
+    for (int i = 0; i < FIX_BENCH_N; i++) {
+        seed = seed * 1103515245 + 12345;
+        a[i] = (fix16_t)seed >> (seed & 15);
+        seed = seed * 1103515245 + 12345;
+        b[i] = ((fix16_t)seed >> (8 + (seed & 15))) | 1;
+    }
+
+    t0 = get_ccount();
+    for (int i = 0; i < FIX_BENCH_N; i++) e[i] = fix_mul(a[i], b[i]);
+    c_exact = get_ccount() - t0;
+    t0 = get_ccount();
+    for (int i = 0; i < FIX_BENCH_N; i++) f[i] = fix_mul_fast(a[i], b[i]);
+    c_fast = get_ccount() - t0;
+    ok = 1;
+    for (int i = 0; i < FIX_BENCH_N; i++)
+        if (e[i] != f[i]) ok = 0;
+    bench_line("fix_mul  ", c_exact, c_fast, ok);
+
+    t0 = get_ccount();
+    for (int i = 0; i < FIX_BENCH_N; i++) e[i] = fix_div(a[i], b[i]);
+    c_exact = get_ccount() - t0;
+    t0 = get_ccount();
+    for (int i = 0; i < FIX_BENCH_N; i++) f[i] = fix_div_fast(a[i], b[i]);
+    c_fast = get_ccount() - t0;
+    ok = 1;
+    for (int i = 0; i < FIX_BENCH_N; i++) {
+        /* Quotients that overflow fix16 are wrong either way */
+        if (fix_abs(a[i] >> 15) >= fix_abs(b[i])) continue;
+        if (fix_abs(e[i] - f[i]) > fix_abs(e[i]) / 10000 + 2) ok = 0;
+    }
+    bench_line("fix_div  ", c_exact, c_fast, ok);
+
+    for (int i = 0; i < FIX_BENCH_N; i++) a[i] = fix_abs(a[i]);
+    t0 = get_ccount();
+    for (int i = 0; i < FIX_BENCH_N; i++) e[i] = fix_sqrt(a[i]);
+    c_exact = get_ccount() - t0;
+    t0 = get_ccount();
+    for (int i = 0; i < FIX_BENCH_N; i++) f[i] = fix_sqrt_fast(a[i]);
+    c_fast = get_ccount() - t0;
+    ok = 1;
+    for (int i = 0; i < FIX_BENCH_N; i++)
+        if (fix_abs(e[i] - f[i]) > e[i] / 15000 + 1) ok = 0;
+    bench_line("fix_sqrt ", c_exact, c_fast, ok);
+}
+
+/*
+ * fix_sin16 over all 65536 angles: cycles per call, and the largest
+ * |sin^2 + cos^2 - 1|, which interpolation error would show up in.
+ */
+static void ICACHE_FLASH_ATTR trig_bench(void)
+{
+    uint32_t t0 = get_ccount();
+    fix16_t sum = 0;
+    for (uint32_t a = 0; a < 65536; a++)
+        sum += fix_sin16((angle16_t)a);
+    uint32_t cycles = get_ccount() - t0;
+
+    fix16_t worst = 0;
+    for (uint32_t a = 0; a < 65536; a++) {
+        fix16_t s = fix_sin16((angle16_t)a), c = fix_cos16((angle16_t)a);
+        fix16_t e = fix_abs(fix_mul(s, s) + fix_mul(c, c) - FIX16_ONE);
+        if (e > worst) worst = e;
+    }
+
+    uart_puts("fix_sin16: ");
+    uart_put_dec(cycles >> 16);
+    uart_puts(" cycles/call, max |sin^2+cos^2-1| = ");
+    uart_put_dec((uint32_t)worst);
+    uart_puts(sum == 0 && worst <= 8 ? " ulp  OK\n" : " ulp  FAIL\n");
+}
+
+void ICACHE_FLASH_ATTR fix_test(void)
 {
     uart_puts("=== Fixed-point 16.16 test ===\n");
 
@@ -188,6 +389,18 @@ void fix_test(void)
         fix_div(FIX16(1), FIX16(4)),
         FIX16_C(0.25), 1);
 
+    /* Reciprocal: 1/3 and 1/0.75, each scaled back to fix16 */
+    int sh;
+    uint32_t r = fix_recip(FIX16(3), &sh);
+    test_case("recip(3)",
+        (fix16_t)(sh >= 0 ? r << sh : r >> -sh),
+        FIX16_C(0.3333), 2);
+
+    r = fix_recip(FIX16_C(0.75), &sh);
+    test_case("recip(0.75)",
+        (fix16_t)(sh >= 0 ? r << sh : r >> -sh),
+        FIX16_C(1.3333), 16);
+
     /* Trigonometry */
     test_case("sin(0)",
         fix_sin(0),
@@ -209,6 +422,20 @@ void fix_test(void)
         fix_cos(128),
         FIX16_NEG_ONE, 1);
 
+    test_case("sin16(0x2000) [45deg]",
+        fix_sin16(0x2000),
+        FIX16_C(0.70711), 2);
+
+    test_case("sin16(0x1555) [30deg]",
+        fix_sin16(0x1555),
+        FIX16_C(0.49997), 3);
+
+    test_case("cos16(0xAAAB) [240deg]",
+        fix_cos16(0xAAAB),
+        FIX16_C(-0.49997), 3);
+
+    trig_bench();
+
     /* Square root */
     test_case("sqrt(4)",
         fix_sqrt(FIX16(4)),
@@ -233,7 +460,19 @@ void fix_test(void)
         fix_lerp(FIX16(0), FIX16(10), FIX16_C(0.5)),
         FIX16(5), 1);
 
+    /* Fast kernels */
+    test_case("fast 10 / 3",
+        fix_div_fast(FIX16(10), FIX16(3)),
+        FIX16_C(3.333), FIX16_C(0.002));
+
+    test_case("fast sqrt(2)",
+        fix_sqrt_fast(FIX16(2)),
+        FIX16_C(1.414), FIX16_C(0.002));
+
+    fix_bench();
+
     uart_puts("=== done ===\n");
 }
+#endif /* OSITO_BENCH */
 
 } /* extern "C" */
@@ -5,8 +5,10 @@
  * Range:  -32768.0 to +32767.99998
  * Precision: 1/65536 ≈ 0.0000153
  *
- * fix_mul uses Xtensa mull+muluh for ~10 cycle multiply.
- * Trigonometry uses 256-entry full-circle sine table (1KB DRAM).
+ * fix_mul, fix_div and fix_sqrt are exact but go through libgcc's
+ * 64-bit helpers; the _fast versions use 32-bit mull only.
+ * Trigonometry uses a 128-entry quarter-wave sine table (256 bytes
+ * DRAM), interpolated for 16-bit angles.
  */
 #ifndef OSITO_FIXEDPOINT_H
 #define OSITO_FIXEDPOINT_H
@@ -21,6 +23,7 @@ extern "C" {
 
 typedef int32_t  fix16_t;   /* 16.16 fixed-point */
 typedef uint8_t  angle_t;   /* 0-255 = 0°-360° */
+typedef uint16_t angle16_t; /* 0-65535 = 0°-360° */
 
 /* ====== Constants ====== */
 
@@ -39,6 +42,9 @@ typedef uint8_t  angle_t;   /* 0-255 = 0°-360° */
 /* Float literal to fix16 (compile-time only) */
 #define FIX16_C(f)        ((fix16_t)((f) * 65536.0 + ((f) >= 0 ? 0.5 : -0.5)))
 
+/* angle_t to angle16_t */
+#define ANGLE16(a)        ((angle16_t)((uint32_t)(uint8_t)(a) << 8))
+
 /* Fix16 to integer (truncate toward zero) */
 #define FIX16_TO_INT(x)   ((int32_t)(x) >> 16)
 
@@ -82,6 +88,18 @@ INLINE fix16_t fix_mul(fix16_t a, fix16_t b)
     return (fix16_t)((int64_t)a * b >> 16);
 }
 
+/*
+ * fix_mul from 16-bit halves: a*b = ah*b*2^16 + al*bh*2^16 + al*bl,
+ * three 32-bit multiplies. Bit for bit the same as fix_mul, overflow
+ * included, since the dropped bits are all below al*bl's top half.
+ */
+INLINE fix16_t fix_mul_fast(fix16_t a, fix16_t b)
+{
+    uint32_t al = (uint32_t)a & 0xFFFF, bl = (uint32_t)b & 0xFFFF;
+    uint32_t ah = (uint32_t)(a >> 16),  bh = (uint32_t)(b >> 16);
+    return (fix16_t)(ah * (uint32_t)b + al * bh + ((al * bl) >> 16));
+}
+
 /* fix16 × integer (simple, no 64-bit needed if result fits) */
 INLINE fix16_t fix_mul_int(fix16_t a, int32_t n)
 {
@@ -126,16 +144,45 @@ fix16_t fix_sin(angle_t angle);
 /* Cosine: cos(a) = sin(a + 64) */
 fix16_t fix_cos(angle_t angle);
 
+/*
+ * Sine and cosine of a 16-bit angle (0.0055° steps), interpolated
+ * between quarter-wave table entries: within 2.1 ulp (3.2e-5) of the
+ * true value. fix_sin(a) == fix_sin16(ANGLE16(a)).
+ */
+fix16_t fix_sin16(angle16_t angle);
+fix16_t fix_cos16(angle16_t angle);
+
 /* Division: a / b, returns fix16. b must not be 0. */
 fix16_t fix_div(fix16_t a, fix16_t b);
 
+/*
+ * Reciprocal without a divide: 1/x (x > 0) is r << shift, or
+ * r >> -shift, in fix16. r is 1/f for x's mantissa f in [1, 2), as
+ * 0.16 (32768 < r <= 65536), good to about 1 part in 10000: a 64-entry
+ * table guess and one Newton step, in 32-bit multiplies only.
+ */
+uint32_t fix_recip(fix16_t x, int *shift);
+
+/*
+ * a / b as a * fix_recip(b): no divide. Off from fix_div by at most
+ * |a / b| / 10000 + 2 ulp. b must not be 0.
+ */
+fix16_t fix_div_fast(fix16_t a, fix16_t b);
+
 /* Square root: x must be >= 0. Returns fix16. */
 fix16_t fix_sqrt(fix16_t x);
 
+/*
+ * Square root from a 48-entry 1/sqrt table and two Newton steps, with
+ * 32-bit multiplies only. Off from fix_sqrt by at most
+ * sqrt(x) / 15000 + 1 ulp. x must be >= 0.
+ */
+fix16_t fix_sqrt_fast(fix16_t x);
+
 /* Print fix16 value to UART as decimal (e.g. "3.141") */
 void fix_print(fix16_t x);
 
-/* Run validation tests (shell fixtest command) */
+/* Run validation tests (shell fixtest command, OSITO_BENCH builds) */
 void fix_test(void);
 
 #ifdef __cplusplus
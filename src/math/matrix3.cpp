@@ -6,6 +6,7 @@
 
 #include "math/matrix3.h"
 #include "drivers/uart.h"
+#include "kernel/config.h"
 
 extern "C" {
 
@@ -16,10 +17,10 @@ extern "C" {
  * | 0   cos   -sin  |
  * | 0   sin    cos  |
  */
-void mat3_rotate_x(mat3_t *out, angle_t angle)
+void mat3_rotate_x16(mat3_t *out, angle16_t angle)
 {
-    fix16_t c = fix_cos(angle);
-    fix16_t s = fix_sin(angle);
+    fix16_t c = fix_cos16(angle);
+    fix16_t s = fix_sin16(angle);
 
     out->m[0][0] = FIX16_ONE; out->m[0][1] = 0;  out->m[0][2] = 0;
     out->m[1][0] = 0;         out->m[1][1] = c;   out->m[1][2] = -s;
@@ -31,10 +32,10 @@ void mat3_rotate_x(mat3_t *out, angle_t angle)
  * |   0   1    0  |
  * | -sin  0   cos |
  */
-void mat3_rotate_y(mat3_t *out, angle_t angle)
+void mat3_rotate_y16(mat3_t *out, angle16_t angle)
 {
-    fix16_t c = fix_cos(angle);
-    fix16_t s = fix_sin(angle);
+    fix16_t c = fix_cos16(angle);
+    fix16_t s = fix_sin16(angle);
 
     out->m[0][0] = c;  out->m[0][1] = 0;         out->m[0][2] = s;
     out->m[1][0] = 0;  out->m[1][1] = FIX16_ONE; out->m[1][2] = 0;
@@ -46,22 +47,60 @@ void mat3_rotate_y(mat3_t *out, angle_t angle)
  * | sin   cos  0 |
  * |  0     0   1 |
  */
-void mat3_rotate_z(mat3_t *out, angle_t angle)
+void mat3_rotate_z16(mat3_t *out, angle16_t angle)
 {
-    fix16_t c = fix_cos(angle);
-    fix16_t s = fix_sin(angle);
+    fix16_t c = fix_cos16(angle);
+    fix16_t s = fix_sin16(angle);
 
     out->m[0][0] = c;  out->m[0][1] = -s; out->m[0][2] = 0;
     out->m[1][0] = s;  out->m[1][1] = c;  out->m[1][2] = 0;
     out->m[2][0] = 0;  out->m[2][1] = 0;  out->m[2][2] = FIX16_ONE;
 }
 
+/* 8-bit angles: the same matrices, at every 256th 16-bit angle */
+void mat3_rotate_x(mat3_t *out, angle_t angle)
+{
+    mat3_rotate_x16(out, ANGLE16(angle));
+}
+
+void mat3_rotate_y(mat3_t *out, angle_t angle)
+{
+    mat3_rotate_y16(out, ANGLE16(angle));
+}
+
+void mat3_rotate_z(mat3_t *out, angle_t angle)
+{
+    mat3_rotate_z16(out, ANGLE16(angle));
+}
+
+/*
+ * Rz * Ry * Rx multiplied out: 12 multiplies, against two 27-multiply
+ * mat3_multiply calls for building the three and combining them.
+ */
+void mat3_rotate_zyx(mat3_t *out, angle_t rx, angle_t ry, angle_t rz)
+{
+    fix16_t cx = fix_cos(rx), sx = fix_sin(rx);
+    fix16_t cy = fix_cos(ry), sy = fix_sin(ry);
+    fix16_t cz = fix_cos(rz), sz = fix_sin(rz);
+    fix16_t sysx = fix_mul_fast(sy, sx), sycx = fix_mul_fast(sy, cx);
+
+    out->m[0][0] = fix_mul_fast(cz, cy);
+    out->m[0][1] = fix_mul_fast(cz, sysx) - fix_mul_fast(sz, cx);
+    out->m[0][2] = fix_mul_fast(cz, sycx) + fix_mul_fast(sz, sx);
+    out->m[1][0] = fix_mul_fast(sz, cy);
+    out->m[1][1] = fix_mul_fast(sz, sysx) + fix_mul_fast(cz, cx);
+    out->m[1][2] = fix_mul_fast(sz, sycx) - fix_mul_fast(cz, sx);
+    out->m[2][0] = -sy;
+    out->m[2][1] = fix_mul_fast(cy, sx);
+    out->m[2][2] = fix_mul_fast(cy, cx);
+}
+
 /* ====== Matrix multiply ====== */
 
 /*
  * out = a * b (3x3 matrix multiplication)
  * out must NOT alias a or b — uses internal temp buffer.
- * 27 fix_mul operations, ~400 cycles.
+ * 27 fix_mul_fast operations (32-bit partial products, same result).
  */
 void mat3_multiply(mat3_t *out, const mat3_t *a, const mat3_t *b)
 {
@@ -69,9 +108,9 @@ void mat3_multiply(mat3_t *out, const mat3_t *a, const mat3_t *b)
 
     for (int i = 0; i < 3; i++) {
         for (int j = 0; j < 3; j++) {
-            tmp.m[i][j] = fix_mul(a->m[i][0], b->m[0][j])
-                        + fix_mul(a->m[i][1], b->m[1][j])
-                        + fix_mul(a->m[i][2], b->m[2][j]);
+            tmp.m[i][j] = fix_mul_fast(a->m[i][0], b->m[0][j])
+                        + fix_mul_fast(a->m[i][1], b->m[1][j])
+                        + fix_mul_fast(a->m[i][2], b->m[2][j]);
         }
     }
 
@@ -92,16 +131,146 @@ vec3_t mat3_transform(const mat3_t *m, vec3_t v)
     return r;
 }
 
+/* ====== Incremental orientation ====== */
+
+void orient_init(orient_t *o, const mat3_t *m)
+{
+    if (m)
+        o->m = *m;
+    else
+        mat3_identity(&o->m);
+    o->turns = 0;
+}
+
+/*
+ * Turning the camera-space result by a small angle a about one axis
+ * mixes two rows of the matrix, with sin a ~ a and cos a ~ 1 - a^2/2.
+ * Rows stay square to each other and grow by only a^4/8 a turn.
+ */
+static void turn_rows(fix16_t *p, fix16_t *q, int32_t angle)
+{
+    /* Bigger turns go in ORIENT_MAX_TURN steps */
+    while (angle > ORIENT_MAX_TURN || angle < -ORIENT_MAX_TURN) {
+        int32_t step = angle > 0 ? ORIENT_MAX_TURN : -ORIENT_MAX_TURN;
+        turn_rows(p, q, step);
+        angle -= step;
+    }
+
+    fix16_t a = (angle * 411775 + 32768) >> 16;     /* angle * 2 pi, radians */
+    fix16_t h = fix_mul_fast(a, a) >> 1;            /* 1 - cos a */
+    for (int j = 0; j < 3; j++) {
+        fix16_t pj = p[j], qj = q[j];
+        p[j] = pj - fix_mul_fast(h, pj) - fix_mul_fast(a, qj);
+        q[j] = qj - fix_mul_fast(h, qj) + fix_mul_fast(a, pj);
+    }
+}
+
+void orient_turn(orient_t *o, int16_t pitch, int16_t yaw, int16_t roll)
+{
+    fix16_t (*r)[3] = o->m.m;
+    if (pitch)
+        turn_rows(r[1], r[2], pitch);   /* y towards z */
+    if (yaw)
+        turn_rows(r[2], r[0], yaw);     /* z towards x */
+    if (roll)
+        turn_rows(r[0], r[1], roll);    /* x towards y */
+    if (++o->turns >= ORIENT_TIDY_TURNS)
+        orient_tidy(o);
+}
+
+/*
+ * Elite's TIDY: make row 0 unit length, make row 1 square to it and
+ * unit length, and take row 2 as their cross product. The rows are
+ * always close to unit length, so v (3 - v.v) / 2 (a Newton step
+ * for 1/|v|) normalises them without a square root or divide.
+ */
+void orient_tidy(orient_t *o)
+{
+    fix16_t (*r)[3] = o->m.m;
+    vec3_t x = vec3(r[0][0], r[0][1], r[0][2]);
+    vec3_t y = vec3(r[1][0], r[1][1], r[1][2]);
+
+    x = vec3_scale(x, (FIX16(3) - vec3_dot(x, x)) >> 1);
+    y = vec3_sub(y, vec3_scale(x, vec3_dot(x, y)));
+    y = vec3_scale(y, (FIX16(3) - vec3_dot(y, y)) >> 1);
+    vec3_t z = vec3_cross(x, y);
+
+    r[0][0] = x.x; r[0][1] = x.y; r[0][2] = x.z;
+    r[1][0] = y.x; r[1][1] = y.y; r[1][2] = y.z;
+    r[2][0] = z.x; r[2][1] = z.y; r[2][2] = z.z;
+    o->turns = 0;
+}
+
+/* ====== Batched transform ====== */
+
+void mat3_to_14(mat3_14_t *out, const mat3_t *m)
+{
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            int32_t e = (m->m[i][j] + 2) >> 2;
+            if (e > 32767) e = 32767;
+            if (e < -32768) e = -32768;
+            out->m[i][j] = (int16_t)e;
+        }
+    }
+}
+
+/* Row sum with sh extra fractional bits to fix16, rounded */
+#define BATCH_ROW(a, b, c, x, y, z, sh) \
+    ((((a) * (x) + (b) * (y) + (c) * (z)) + (1 << ((sh) - 1))) >> (sh))
+
+void mat3_transform_batch(const mat3_14_t *m, vec3_t pos,
+                          const vec3_t *v, const int16_t *v88,
+                          const uint8_t *idx, int n,
+                          fix16_t *ox, fix16_t *oy, fix16_t *oz)
+{
+    /* Matrix in registers for the whole batch */
+    const int32_t m00 = m->m[0][0], m01 = m->m[0][1], m02 = m->m[0][2];
+    const int32_t m10 = m->m[1][0], m11 = m->m[1][1], m12 = m->m[1][2];
+    const int32_t m20 = m->m[2][0], m21 = m->m[2][1], m22 = m->m[2][2];
+
+    if (v) {
+        for (int k = 0; k < n; k++) {
+            const vec3_t *p = &v[idx ? idx[k] : k];
+            int32_t x = (p->x + 8) >> 4;      /* 4.12: 2.14 x 4.12 = 6.26 */
+            int32_t y = (p->y + 8) >> 4;
+            int32_t z = (p->z + 8) >> 4;
+            ox[k] = BATCH_ROW(m00, m01, m02, x, y, z, 10) + pos.x;
+            oy[k] = BATCH_ROW(m10, m11, m12, x, y, z, 10) + pos.y;
+            oz[k] = BATCH_ROW(m20, m21, m22, x, y, z, 10) + pos.z;
+        }
+    } else {
+        for (int k = 0; k < n; k++) {
+            const int16_t *p = v88 + (idx ? idx[k] : k) * 3;
+            int32_t x = p[0], y = p[1], z = p[2];  /* 2.14 x 8.8 = 10.22 */
+            ox[k] = BATCH_ROW(m00, m01, m02, x, y, z, 6) + pos.x;
+            oy[k] = BATCH_ROW(m10, m11, m12, x, y, z, 6) + pos.y;
+            oz[k] = BATCH_ROW(m20, m21, m22, x, y, z, 6) + pos.z;
+        }
+    }
+}
+
 /* ====== Perspective projection ====== */
 
+/*
+ * focal / z comes from fix_recip(z) rather than fix_div, so the whole
+ * projection is 32-bit multiplies and shifts. Against the fix_div
+ * path a coordinate differs by at most one pixel, and only where the
+ * exact value lies within about 0.01 pixel of a rounding boundary.
+ */
 int project(vec3_t v, fix16_t focal, int *sx, int *sy)
 {
     if (v.z <= FIX16_C(0.5))
         return 0;  /* behind camera */
 
-    fix16_t inv_z = fix_div(focal, v.z);
-    *sx = 64 + FIX16_ROUND(fix_mul(v.x, inv_z));
-    *sy = 32 - FIX16_ROUND(fix_mul(v.y, inv_z));
+    int sh;
+    uint32_t r = fix_recip(v.z, &sh);
+    uint32_t f = (uint32_t)focal;
+    uint32_t inv_z = (f >> 16) * r + (((f & 0xFFFF) * r) >> 16);
+    inv_z = sh >= 0 ? inv_z << sh : inv_z >> -sh;     /* z > 0.5: sh <= 1 */
+
+    *sx = 64 + FIX16_ROUND(fix_mul_fast(v.x, (fix16_t)inv_z));
+    *sy = 32 - FIX16_ROUND(fix_mul_fast(v.y, (fix16_t)inv_z));
     return 1;
 }
 
@@ -131,9 +300,10 @@ void mat3_print(const mat3_t *m)
     }
 }
 
+#if OSITO_BENCH
 /* ====== Test suite ====== */
 
-static void mat3_test_case(const char *label, vec3_t got, vec3_t expected, fix16_t tol)
+static void ICACHE_FLASH_ATTR mat3_test_case(const char *label, vec3_t got, vec3_t expected, fix16_t tol)
 {
     uart_puts(label);
     uart_puts(" = ");
@@ -152,7 +322,7 @@ static void mat3_test_case(const char *label, vec3_t got, vec3_t expected, fix16
     }
 }
 
-static void mat3_test_scalar(const char *label, fix16_t got, fix16_t expected, fix16_t tol)
+static void ICACHE_FLASH_ATTR mat3_test_scalar(const char *label, fix16_t got, fix16_t expected, fix16_t tol)
 {
     uart_puts(label);
     uart_puts(" = ");
@@ -167,7 +337,165 @@ static void mat3_test_scalar(const char *label, fix16_t got, fix16_t expected, f
     }
 }
 
-void mat3_test(void)
+/*
+ * Batched 2.14 transform against mat3_transform: worst error over
+ * 16 rotations of 16 points within +-4 units, and cycles per vertex.
+ */
+#define BATCH_TEST_N  16
+
+static void ICACHE_FLASH_ATTR mat3_test_batch(void)
+{
+    vec3_t v[BATCH_TEST_N];
+    fix16_t ox[BATCH_TEST_N], oy[BATCH_TEST_N], oz[BATCH_TEST_N];
+    uint32_t seed = 12345, c_ref = 0, c_batch = 0;
+    fix16_t worst = 0;
+
+    for (int i = 0; i < BATCH_TEST_N; i++) {
+        seed = seed * 1103515245 + 12345;
+        v[i].x = (fix16_t)(seed >> 8) % FIX16(4);
+        seed = seed * 1103515245 + 12345;
+        v[i].y = (fix16_t)(seed >> 8) % FIX16(8) - FIX16(4);
+        seed = seed * 1103515245 + 12345;
+        v[i].z = -((fix16_t)(seed >> 8) % FIX16(4));
+    }
+
+    for (int a = 0; a < 16; a++) {
+        mat3_t rx, ry, m;
+        mat3_14_t m14;
+        vec3_t pos = vec3(FIX16(a - 8), FIX16(1), FIX16(20));
+
+        mat3_rotate_x(&rx, (angle_t)(a * 37));
+        mat3_rotate_y(&ry, (angle_t)(a * 16 + 5));
+        mat3_multiply(&m, &rx, &ry);
+
+        uint32_t t0 = get_ccount();
+        for (int i = 0; i < BATCH_TEST_N; i++) {
+            vec3_t r = vec3_add(mat3_transform(&m, v[i]), pos);
+            ox[i] = r.x; oy[i] = r.y; oz[i] = r.z;
+        }
+        c_ref += get_ccount() - t0;
+
+        /* The reference results are kept to compare against */
+        vec3_t ref[BATCH_TEST_N];
+        for (int i = 0; i < BATCH_TEST_N; i++)
+            ref[i] = vec3(ox[i], oy[i], oz[i]);
+
+        t0 = get_ccount();
+        mat3_to_14(&m14, &m);
+        mat3_transform_batch(&m14, pos, v, nullptr, nullptr, BATCH_TEST_N,
+                             ox, oy, oz);
+        c_batch += get_ccount() - t0;
+
+        for (int i = 0; i < BATCH_TEST_N; i++) {
+            fix16_t e = fix_abs(ox[i] - ref[i].x);
+            if (fix_abs(oy[i] - ref[i].y) > e) e = fix_abs(oy[i] - ref[i].y);
+            if (fix_abs(oz[i] - ref[i].z) > e) e = fix_abs(oz[i] - ref[i].z);
+            if (e > worst) worst = e;
+        }
+    }
+
+    uart_puts("batch: cycles/vertex ");
+    uart_put_dec(c_ref / (16 * BATCH_TEST_N));
+    uart_puts(" -> ");
+    uart_put_dec(c_batch / (16 * BATCH_TEST_N));
+    uart_puts(", max err ");
+    fix_print(worst);
+    uart_puts(worst <= FIX16_C(0.001) ? "  OK\n" : "  FAIL\n");
+}
+
+/*
+ * project() against the fix_div path it replaced, over z from 0.5 to
+ * 64 (the game's ships sit at 4 to 8) and points across the view:
+ * cycles per point and how many coordinates differ, by at most 1.
+ */
+static void ICACHE_FLASH_ATTR mat3_test_project(void)
+{
+    uint32_t c_div = 0, c_recip = 0, n = 0, diff = 0, worst = 0;
+
+    for (fix16_t z = FIX16_C(0.51); z < FIX16(64); z += z / 8 + 1) {
+        for (int i = -4; i <= 4; i++) {
+            vec3_t v = vec3(fix_mul(z, FIX16(i) / 4) + 1000 * i,
+                            fix_mul(z, FIX16(i) / 8) - 777 * i, z);
+            int ax, ay, bx, by;
+
+            uint32_t t0 = get_ccount();
+            fix16_t inv_z = fix_div(FIX16(64), v.z);
+            ax = 64 + FIX16_ROUND(fix_mul(v.x, inv_z));
+            ay = 32 - FIX16_ROUND(fix_mul(v.y, inv_z));
+            uint32_t t1 = get_ccount();
+            project(v, FIX16(64), &bx, &by);
+            uint32_t t2 = get_ccount();
+
+            c_div += t1 - t0;
+            c_recip += t2 - t1;
+            n++;
+            uint32_t dx = (uint32_t)(ax > bx ? ax - bx : bx - ax);
+            uint32_t dy = (uint32_t)(ay > by ? ay - by : by - ay);
+            if (dx) diff++;
+            if (dy) diff++;
+            if (dx > worst) worst = dx;
+            if (dy > worst) worst = dy;
+        }
+    }
+
+    uart_puts("project: cycles/point fix_div ");
+    uart_put_dec(c_div / n);
+    uart_puts(" -> recip ");
+    uart_put_dec(c_recip / n);
+    uart_puts(", ");
+    uart_put_dec(diff);
+    uart_puts(" of ");
+    uart_put_dec(n * 2);
+    uart_puts(" coords differ");
+    uart_puts(worst <= 1 ? "  OK\n" : "  FAIL\n");
+}
+
+/*
+ * 1000 frames of a wirespin-style tumble, rebuilt from angles each
+ * frame against turned with orient_turn: cycles per frame, and how
+ * far the turned matrix strays from orthonormal (worst |r_i . r_j -
+ * delta_ij| over the run).
+ */
+static void ICACHE_FLASH_ATTR mat3_test_orient(void)
+{
+    orient_t o;
+    mat3_t rx, ry, rot;
+    uint32_t c_abs = 0, c_inc = 0, t0;
+    fix16_t worst = 0;
+
+    orient_init(&o, nullptr);
+    for (int f = 0; f < 1000; f++) {
+        t0 = get_ccount();
+        mat3_rotate_x(&rx, (angle_t)f);
+        mat3_rotate_y(&ry, (angle_t)(f * 3));
+        mat3_multiply(&rot, &ry, &rx);
+        c_abs += get_ccount() - t0;
+
+        t0 = get_ccount();
+        orient_turn(&o, ANGLE16(1), ANGLE16(3), 0);
+        c_inc += get_ccount() - t0;
+
+        for (int i = 0; i < 3; i++) {
+            for (int j = i; j < 3; j++) {
+                fix16_t d = fix_mul(o.m.m[i][0], o.m.m[j][0])
+                          + fix_mul(o.m.m[i][1], o.m.m[j][1])
+                          + fix_mul(o.m.m[i][2], o.m.m[j][2]);
+                d = fix_abs(d - (i == j ? FIX16_ONE : 0));
+                if (d > worst) worst = d;
+            }
+        }
+    }
+
+    uart_puts("orient: cycles/frame rebuild ");
+    uart_put_dec(c_abs / 1000);
+    uart_puts(" -> turn ");
+    uart_put_dec(c_inc / 1000);
+    uart_puts(", max orthonormal err ");
+    fix_print(worst);
+    uart_puts(worst <= FIX16_C(0.005) ? "  OK\n" : "  FAIL\n");
+}
+
+void ICACHE_FLASH_ATTR mat3_test(void)
 {
     mat3_t m, rx, ry, combined;
     vec3_t v, r;
@@ -242,7 +570,12 @@ void mat3_test(void)
         vec3_length(vec3(FIX16(3), FIX16(4), 0)),
         FIX16(5), FIX16_C(0.01));
 
+    mat3_test_batch();
+    mat3_test_project();
+    mat3_test_orient();
+
     uart_puts("=== done ===\n");
 }
+#endif /* OSITO_BENCH */
 
 } /* extern "C" */
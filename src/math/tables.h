@@ -0,0 +1,100 @@
+/*
+ * OsitoK - Compile-time lookup table generators
+ *
+ * constexpr (C++17) builders for the fixed-point math tables. A
+ * table's size and entry format are template arguments, and the
+ * compiler computes the entries: no pasted literals to regenerate by
+ * hand, and nothing to fill in at boot. The double arithmetic here
+ * only runs in the compiler; no float code reaches the image.
+ *
+ * C++ only: include from .cpp files, outside extern "C".
+ */
+#ifndef OSITO_TABLES_H
+#define OSITO_TABLES_H
+
+#include "kernel/types.h"
+
+/* A fixed-size table that a constexpr function can fill and return */
+template <typename T, int N>
+struct lut_t {
+    T v[N];
+
+    constexpr const T &operator[](int i) const { return v[i]; }
+};
+
+/* ====== Compile-time helpers ====== */
+
+constexpr double LUT_PI = 3.14159265358979323846;
+
+/* sin x for 0 <= x <= pi/2: Taylor series to well past double precision */
+constexpr double lut_sin(double x)
+{
+    double term = x, sum = x;
+    for (int k = 1; k < 12; k++) {
+        term *= -x * x / ((2 * k) * (2 * k + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+/* sqrt x for 1 <= x < 4, by Newton's method */
+constexpr double lut_sqrt(double x)
+{
+    double r = x;
+    for (int k = 0; k < 8; k++)
+        r = (r + x / r) / 2;
+    return r;
+}
+
+/* Round half away from zero, as FIX16_C does */
+constexpr int64_t lut_round(double x)
+{
+    return (int64_t)(x >= 0 ? x + 0.5 : x - 0.5);
+}
+
+/* x, saturated to the range of T (an integer type up to 32 bits):
+ * entries next to 1.0 in a 0.16 table would otherwise wrap to 0 */
+template <typename T>
+constexpr T lut_fit(int64_t x)
+{
+    constexpr int64_t hi = (T)-1 < 0 ? ((int64_t)1 << (8 * sizeof(T) - 1)) - 1
+                                     : (int64_t)(T)-1;
+    constexpr int64_t lo = (T)-1 < 0 ? -hi - 1 : 0;
+    return (T)(x > hi ? hi : x < lo ? lo : x);
+}
+
+/* ====== Generators ====== */
+
+/* Quarter-wave sine: v[i] = one * sin(i * 90° / N), 0 <= i < N */
+template <typename T, int N, int64_t ONE>
+constexpr lut_t<T, N> lut_quarter_sin()
+{
+    lut_t<T, N> t = {};
+    for (int i = 0; i < N; i++)
+        t.v[i] = lut_fit<T>(lut_round(ONE * lut_sin(i * (LUT_PI / 2) / N)));
+    return t;
+}
+
+/* Reciprocal seeds: v[i] = one / f at the middle of the i-th of N
+ * equal steps of f over [1, 2) */
+template <typename T, int N, int64_t ONE>
+constexpr lut_t<T, N> lut_recip()
+{
+    lut_t<T, N> t = {};
+    for (int i = 0; i < N; i++)
+        t.v[i] = lut_fit<T>(lut_round(ONE / (1 + (i + 0.5) / N)));
+    return t;
+}
+
+/* 1/sqrt seeds: v[i] = one / sqrt(f) at the middle of the i-th step
+ * of f over [1, 4), K steps per unit (3K entries) */
+template <typename T, int K, int64_t ONE>
+constexpr lut_t<T, 3 * K> lut_rsqrt()
+{
+    lut_t<T, 3 * K> t = {};
+    for (int i = 0; i < 3 * K; i++)
+        t.v[i] = lut_fit<T>(lut_round(ONE / lut_sqrt(1 + (i + 0.5) / K)));
+    return t;
+}
+
+#endif /* OSITO_TABLES_H */
@@ -16,15 +16,20 @@
 #include "drivers/adc.h"
 #include "drivers/input.h"
 #include "drivers/video.h"
+#include "drivers/font.h"
 #include "mem/pool_alloc.h"
 #include "mem/heap.h"
 #include "fs/ositofs.h"
+#include "fs/fcache.h"
+#include "fs/flashio.h"
 #include "kernel/task.h"
 #include "kernel/timer_sw.h"
 #include "math/fixedpoint.h"
 #include "math/matrix3.h"
 #include "gfx/wire3d.h"
 #include "gfx/ships.h"
+#include "gfx/fbrec.h"
+#include "gfx/wmodel.h"
 #include "game/game.h"
 
 extern "C" {
@@ -159,6 +164,59 @@ static void cmd_heap(const char *args)
 
 /* ====== Filesystem commands ====== */
 
+/* Inline length: the ROM ets_strlen faults from task context */
+static int str_len(const char *s)
+{
+    int n = 0;
+    while (s[n]) n++;
+    return n;
+}
+
+/* fs ls [PATTERN]: one line per entry from the directory cursor */
+static void list_files(const char *pattern)
+{
+    fs_dir_t d;
+    if (!fs_mounted()) { uart_puts("fs: not mounted\n"); return; }
+    if (fs_opendir(&d, *pattern ? pattern : nullptr) < 0) {
+        uart_puts("fs: no such directory\n");
+        return;
+    }
+
+    uart_puts("Name                     Size  Sec\n");
+    fs_dirinfo_t info;
+    int count = 0;
+    while (fs_readdir(&d, &info) > 0) {
+        /* Path padded to 25 chars */
+        uart_puts(info.name);
+        int len = str_len(info.name);
+        if (info.type == FS_TYPE_DIR) {
+            uart_putc('/');
+            len++;
+        }
+        for (int j = len; j < 25; j++) uart_putc(' ');
+
+        if (info.type == FS_TYPE_DIR) {
+            uart_puts("<dir>\n");
+        } else {
+            uart_put_dec(info.size);
+            uart_puts("  ");
+            uart_put_dec(info.sectors);
+            if (info.frag_units) {
+                uart_putc('+');
+                uart_put_dec(info.frag_units);
+            }
+            if (info.flags & FS_F_COMPRESSED) {
+                uart_puts("  z ");
+                uart_put_dec(info.stored);
+            }
+            uart_puts("\n");
+        }
+        count++;
+    }
+    if (count == 0)
+        uart_puts("(empty)\n");
+}
+
 static void cmd_fs(const char *args)
 {
     while (*args == ' ') args++;
@@ -166,16 +224,22 @@ static void cmd_fs(const char *args)
     if (*args == '\0' || ets_strcmp(args, "help") == 0) {
         uart_puts("fs commands:\n");
         uart_puts("  fs format          - create filesystem\n");
-        uart_puts("  fs ls              - list files\n");
-        uart_puts("  fs df              - free space\n");
+        uart_puts("  fs ls [PATTERN]    - list files (DIR/ or name prefix)\n");
+        uart_puts("  fs df [-v]         - free space (-v: read cache stats)\n");
+        uart_puts("  fs cache [BYTES [PAGE]] - show/resize read cache (0 = off)\n");
+#if OSITO_BENCH
+        uart_puts("  fs zstat NAME      - compression ratio, read speed\n");
+#endif
         uart_puts("  fs cat NAME        - print file\n");
         uart_puts("  fs write NAME DATA - write text file\n");
         uart_puts("  fs overwrite NAME DATA - overwrite file\n");
         uart_puts("  fs append NAME DATA - append to file\n");
         uart_puts("  fs mv OLD NEW      - rename file\n");
         uart_puts("  fs rm NAME         - delete file\n");
+        uart_puts("  fs mkdir DIR       - create directory\n");
+        uart_puts("  fs rmdir DIR       - remove empty directory\n");
         uart_puts("  fs xxd NAME        - hex dump file\n");
-        uart_puts("  fs upload NAME SIZE - binary upload\n");
+        uart_puts("  fs upload NAME SIZE [RAW] - binary upload (RAW: LZSS)\n");
         return;
     }
 
@@ -184,12 +248,14 @@ static void cmd_fs(const char *args)
         return;
     }
 
-    if (ets_strcmp(args, "ls") == 0) {
-        fs_list();
+    if (ets_strcmp(args, "ls") == 0 || ets_strncmp(args, "ls ", 3) == 0) {
+        args += 2;
+        while (*args == ' ') args++;
+        list_files(args);
         return;
     }
 
-    if (ets_strcmp(args, "df") == 0) {
+    if (ets_strcmp(args, "df") == 0 || ets_strcmp(args, "df -v") == 0) {
         if (!fs_mounted()) { uart_puts("fs: not mounted\n"); return; }
         uint32_t free_bytes = fs_free();
         uart_puts("Free: ");
@@ -197,6 +263,79 @@ static void cmd_fs(const char *args)
         uart_puts(" KB (");
         uart_put_dec(free_bytes);
         uart_puts(" bytes)\n");
+        if (args[2] == '\0') return;
+
+        /* Flash I/O task counters */
+        flashio_stats_t *io = flashio_stats();
+        uart_puts("Flash I/O: ");
+        uart_put_dec(io->erases);
+        uart_puts(" erases (");
+        uart_put_dec(io->erase_ticks);
+        uart_puts(" ticks asleep), ");
+        uart_put_dec(io->programs);
+        uart_puts(" programs, ");
+        uart_put_dec(io->program_bytes);
+        uart_puts(" bytes, queue peak ");
+        uart_put_dec(io->queue_peak);
+        uart_puts("\n");
+
+        /* Read cache geometry and counters */
+        uart_puts("Cache: ");
+        if (fcache_pages() == 0) { uart_puts("off\n"); return; }
+        uart_put_dec(fcache_pages());
+        uart_puts(" x ");
+        uart_put_dec(fcache_page_size());
+        uart_puts(" bytes (");
+        uart_put_dec(fcache_heap_bytes());
+        uart_puts(" heap)\n");
+        fcache_stats_t *cs = fcache_stats();
+        uint32_t lookups = cs->hits + cs->misses;
+        uart_puts("  hits ");
+        uart_put_dec(cs->hits);
+        uart_puts(", misses ");
+        uart_put_dec(cs->misses);
+        uart_puts(" (");
+        uart_put_dec(lookups == 0 ? 0 : lookups < 40000000 ?
+                     cs->hits * 100 / lookups : cs->hits / (lookups / 100));
+        uart_puts("% hit)\n  read-ahead ");
+        uart_put_dec(cs->readahead);
+        uart_puts(", invalidated ");
+        uart_put_dec(cs->invalidated);
+        uart_puts(", bypassed ");
+        uart_put_dec(cs->bypass);
+        uart_puts("\n");
+        return;
+    }
+
+    if (ets_strcmp(args, "cache") == 0 || ets_strncmp(args, "cache ", 6) == 0) {
+        const char *p = args + 5;
+        while (*p == ' ') p++;
+        if (*p == '\0') {
+            uart_put_dec(fcache_pages());
+            uart_puts(" pages x ");
+            uart_put_dec(fcache_page_size());
+            uart_puts(" bytes, ");
+            uart_put_dec(fcache_heap_bytes());
+            uart_puts(" heap bytes\n");
+            return;
+        }
+
+        uint32_t vals[2] = { 0, FS_CACHE_PAGE };
+        for (int i = 0; i < 2 && *p; i++) {
+            if (*p < '0' || *p > '9') { uart_puts("usage: fs cache [bytes [page]]\n"); return; }
+            vals[i] = 0;
+            while (*p >= '0' && *p <= '9')
+                vals[i] = vals[i] * 10 + (*p++ - '0');
+            while (*p == ' ') p++;
+        }
+        if (fcache_config(vals[0], vals[1]) < 0) {
+            uart_puts("cache: bad size or no heap (now off)\n");
+            return;
+        }
+        fcache_reset_stats();
+        uart_puts("cache: ");
+        uart_put_dec(fcache_pages());
+        uart_puts(" pages\n");
         return;
     }
 
@@ -205,25 +344,69 @@ static void cmd_fs(const char *args)
         while (*name == ' ') name++;
         if (*name == '\0') { uart_puts("usage: fs cat <name>\n"); return; }
 
-        int size = fs_stat(name);
-        if (size < 0) { uart_puts("not found\n"); return; }
-        if (size == 0) { return; }
+        /* Stream in chunks using heap (handle holds the LZSS window) */
+        fs_file_t *f = (fs_file_t *)heap_alloc(sizeof(fs_file_t) + 128);
+        if (!f) { uart_puts("no memory\n"); return; }
+        uint8_t *buf = (uint8_t *)(f + 1);
 
-        /* Read in chunks using heap */
-        uint32_t chunk = (uint32_t)size < 512 ? (uint32_t)size : 512;
-        uint8_t *buf = (uint8_t *)heap_alloc(chunk);
-        if (!buf) { uart_puts("no memory\n"); return; }
-
-        int got = fs_read(name, buf, chunk);
-        if (got > 0) {
+        if (fs_open(f, name) < 0) {
+            heap_free(f);
+            uart_puts("not found\n");
+            return;
+        }
+        int got, last = '\n';
+        while ((got = fs_fread(f, buf, 128)) > 0) {
             for (int i = 0; i < got; i++)
                 uart_putc((char)buf[i]);
-            if (buf[got - 1] != '\n')
-                uart_puts("\n");
+            last = buf[got - 1];
         }
-        heap_free(buf);
+        if (last != '\n')
+            uart_puts("\n");
+        heap_free(f);
+        return;
+    }
+
+#if OSITO_BENCH
+    if (ets_strncmp(args, "zstat ", 6) == 0) {
+        const char *name = args + 6;
+        while (*name == ' ') name++;
+        if (*name == '\0') { uart_puts("usage: fs zstat <name>\n"); return; }
+
+        fs_file_t *f = (fs_file_t *)heap_alloc(sizeof(fs_file_t) + 256);
+        if (!f) { uart_puts("no memory\n"); return; }
+        uint8_t *buf = (uint8_t *)(f + 1);
+
+        if (fs_open(f, name) < 0) {
+            heap_free(f);
+            uart_puts("not found\n");
+            return;
+        }
+
+        /* Time a full streaming read (flash + decode) */
+        uint32_t t0 = get_ccount();
+        uint32_t total = 0;
+        int got;
+        while ((got = fs_fread(f, buf, 256)) > 0)
+            total += (uint32_t)got;
+        uint32_t cycles = get_ccount() - t0;
+
+        uart_puts(f->flags & FS_F_COMPRESSED ? "compressed: " : "plain: ");
+        uart_put_dec(f->stored);
+        uart_puts(" -> ");
+        uart_put_dec(f->size);
+        uart_puts(" bytes (");
+        uart_put_dec(f->size ? f->stored * 100 / f->size : 100);
+        uart_puts("%)\nread: ");
+        uart_put_dec(total);
+        uart_puts(" bytes in ");
+        uart_put_dec(cycles / (CPU_FREQ_HZ / 1000000));
+        uart_puts(" us = ");
+        uart_put_dec(cycles ? (uint32_t)((uint64_t)total * (CPU_FREQ_HZ / 1024) / cycles) : 0);
+        uart_puts(" KB/s\n");
+        heap_free(f);
         return;
     }
+#endif
 
     if (ets_strncmp(args, "xxd ", 4) == 0) {
         const char *name = args + 4;
@@ -260,9 +443,9 @@ static void cmd_fs(const char *args)
         while (*rest == ' ') rest++;
 
         /* Extract filename (until next space) */
-        char name[FS_NAME_LEN];
+        char name[FS_PATH_LEN];
         int ni = 0;
-        while (*rest && *rest != ' ' && ni < FS_NAME_LEN - 1)
+        while (*rest && *rest != ' ' && ni < FS_PATH_LEN - 1)
             name[ni++] = *rest++;
         name[ni] = '\0';
 
@@ -291,9 +474,9 @@ static void cmd_fs(const char *args)
         const char *rest = args + 10;
         while (*rest == ' ') rest++;
 
-        char name[FS_NAME_LEN];
+        char name[FS_PATH_LEN];
         int ni = 0;
-        while (*rest && *rest != ' ' && ni < FS_NAME_LEN - 1)
+        while (*rest && *rest != ' ' && ni < FS_PATH_LEN - 1)
             name[ni++] = *rest++;
         name[ni] = '\0';
 
@@ -319,9 +502,9 @@ static void cmd_fs(const char *args)
         const char *rest = args + 7;
         while (*rest == ' ') rest++;
 
-        char name[FS_NAME_LEN];
+        char name[FS_PATH_LEN];
         int ni = 0;
-        while (*rest && *rest != ' ' && ni < FS_NAME_LEN - 1)
+        while (*rest && *rest != ' ' && ni < FS_PATH_LEN - 1)
             name[ni++] = *rest++;
         name[ni] = '\0';
 
@@ -349,18 +532,18 @@ static void cmd_fs(const char *args)
         const char *rest = args + 3;
         while (*rest == ' ') rest++;
 
-        char old_name[FS_NAME_LEN];
+        char old_name[FS_PATH_LEN];
         int ni = 0;
-        while (*rest && *rest != ' ' && ni < FS_NAME_LEN - 1)
+        while (*rest && *rest != ' ' && ni < FS_PATH_LEN - 1)
             old_name[ni++] = *rest++;
         old_name[ni] = '\0';
 
         if (ni == 0) { uart_puts("usage: fs mv <old> <new>\n"); return; }
         while (*rest == ' ') rest++;
 
-        char new_name[FS_NAME_LEN];
+        char new_name[FS_PATH_LEN];
         ni = 0;
-        while (*rest && *rest != ' ' && ni < FS_NAME_LEN - 1)
+        while (*rest && *rest != ' ' && ni < FS_PATH_LEN - 1)
             new_name[ni++] = *rest++;
         new_name[ni] = '\0';
 
@@ -383,18 +566,18 @@ static void cmd_fs(const char *args)
         while (*rest == ' ') rest++;
 
         /* Parse filename */
-        char name[FS_NAME_LEN];
+        char name[FS_PATH_LEN];
         int ni = 0;
-        while (*rest && *rest != ' ' && ni < FS_NAME_LEN - 1)
+        while (*rest && *rest != ' ' && ni < FS_PATH_LEN - 1)
             name[ni++] = *rest++;
         name[ni] = '\0';
 
-        if (ni == 0) { uart_puts("usage: fs upload <name> <size>\n"); return; }
+        if (ni == 0) { uart_puts("usage: fs upload <name> <size> [raw]\n"); return; }
         while (*rest == ' ') rest++;
 
         /* Parse size */
         if (*rest < '0' || *rest > '9') {
-            uart_puts("usage: fs upload <name> <size>\n");
+            uart_puts("usage: fs upload <name> <size> [raw]\n");
             return;
         }
         uint32_t total_size = 0;
@@ -404,8 +587,16 @@ static void cmd_fs(const char *args)
         }
         if (total_size == 0) { uart_puts("size must be > 0\n"); return; }
 
+        /* Optional decompressed size: data is an LZSS stream */
+        while (*rest == ' ') rest++;
+        uint32_t raw_size = 0;
+        while (*rest >= '0' && *rest <= '9') {
+            raw_size = raw_size * 10 + (*rest - '0');
+            rest++;
+        }
+
         /* fs_upload handles everything: alloc, UART read, flash write, ACK */
-        fs_upload(name, total_size);
+        fs_upload(name, total_size, raw_size);
         return;
     }
 
@@ -421,6 +612,30 @@ static void cmd_fs(const char *args)
         return;
     }
 
+    if (ets_strncmp(args, "mkdir ", 6) == 0) {
+        const char *name = args + 6;
+        while (*name == ' ') name++;
+        if (*name == '\0') { uart_puts("usage: fs mkdir <dir>\n"); return; }
+
+        if (fs_mkdir(name) == 0)
+            uart_puts("created\n");
+        else
+            uart_puts("mkdir failed\n");
+        return;
+    }
+
+    if (ets_strncmp(args, "rmdir ", 6) == 0) {
+        const char *name = args + 6;
+        while (*name == ' ') name++;
+        if (*name == '\0') { uart_puts("usage: fs rmdir <dir>\n"); return; }
+
+        if (fs_rmdir(name) == 0)
+            uart_puts("removed\n");
+        else
+            uart_puts("not found or not empty\n");
+        return;
+    }
+
     uart_puts("unknown fs command (try 'fs help')\n");
 }
 
@@ -449,13 +664,22 @@ static void cmd_help(void)
     uart_puts("  forth   - Forth REPL\n");
     uart_puts("  joy     - joystick live monitor\n");
     uart_puts("  fbtest  - framebuffer test pattern\n");
+    uart_puts("  video   - bridge mode raw|delta|list|key, bytes/frame\n");
+#if OSITO_BENCH
+    uart_puts("  linebench- line drawing cycles per line\n");
+    uart_puts("  textbench- text drawing cycles per character\n");
     uart_puts("  fixtest - fixed-point math test\n");
     uart_puts("  mat3test- 3D matrix/vector test\n");
+#endif
     uart_puts("  wiretest- wireframe cube (static)\n");
     uart_puts("  wirespin- wireframe cube (anim)\n");
     uart_puts("  ship    - show Elite ship model\n");
     uart_puts("  shipspin- spin all ships (anim)\n");
+    uart_puts("  model   - list/load/show wireframe models\n");
     uart_puts("  elite   - Elite flight demo\n");
+#if OSITO_FBREC
+    uart_puts("  rec     - record/play framebuffer demos\n");
+#endif
     uart_puts("  uname   - system info\n");
     uart_puts("  help    - this message\n");
     uart_puts("  reboot  - software reset\n");
@@ -719,6 +943,238 @@ static void cmd_adc(void)
     uart_puts("\n");
 }
 
+/* video [raw|delta|list|key]: bridge transfer mode and traffic counters */
+static void cmd_video(const char *args)
+{
+    static const char *const modes[] = { "raw", "delta", "list" };
+    while (*args == ' ') args++;
+
+    int m = 0;
+    while (m < 3 && ets_strcmp(args, modes[m]) != 0) m++;
+    if (m < 3) {
+        video_set_mode(m);
+        video_reset_stats();
+    } else if (ets_strcmp(args, "key") == 0) {
+        video_key_frame();
+    } else if (*args != '\0') {
+        uart_puts("usage: video [raw|delta|list|key]\n");
+        return;
+    }
+
+    video_stats_t *vs = video_stats();
+    uart_puts("video: ");
+    uart_puts(modes[video_mode()]);
+    uart_puts(", ");
+    uart_put_dec(vs->frames);
+    uart_puts(" frames (");
+    uart_put_dec(vs->key_frames);
+    uart_puts(" key, ");
+    uart_put_dec(vs->list_frames);
+    uart_puts(" list), ");
+    uart_put_dec(vs->bytes);
+    uart_puts(" bytes, ");
+    uart_put_dec(vs->frames ? vs->bytes / vs->frames : 0);
+    uart_puts("/frame, ");
+    uart_put_dec(vs->wait_ticks);
+    uart_puts(" ticks waiting for the UART\n");
+}
+
+#if OSITO_BENCH
+/* ====== linebench: fb_line against per-pixel Bresenham ====== */
+
+/* fb_line as it was: fb_set_pixel for every pixel, off screen too */
+static void ICACHE_FLASH_ATTR ref_line(int x0, int y0, int x1, int y1)
+{
+    int dx = x1 - x0, dy = y1 - y0, sx = 1, sy = 1;
+    if (dx < 0) { dx = -dx; sx = -1; }
+    if (dy < 0) { dy = -dy; sy = -1; }
+    int err;
+    if (dx >= dy) {
+        err = dx >> 1;
+        for (int i = 0; i <= dx; i++) {
+            fb_set_pixel(x0, y0);
+            err -= dy;
+            if (err < 0) { y0 += sy; err += dx; }
+            x0 += sx;
+        }
+    } else {
+        err = dy >> 1;
+        for (int i = 0; i <= dy; i++) {
+            fb_set_pixel(x0, y0);
+            err -= dx;
+            if (err < 0) { x0 += sx; err += dy; }
+            y0 += sy;
+        }
+    }
+}
+
+#define BENCH_LINES 64
+
+/* Endpoints for test set t: short, long, horizontal/vertical, off screen */
+static void ICACHE_FLASH_ATTR bench_coords(int t, uint32_t *seed, int *c)
+{
+    for (int i = 0; i < 4; i++) {
+        *seed = *seed * 1103515245 + 12345;
+        int r = (int)((*seed >> 16) & 0x7FFF);
+        int lim = (i & 1) ? FB_HEIGHT : FB_WIDTH;
+        if (t == 0 && i >= 2)
+            c[i] = c[i - 2] + r % 21 - 10;
+        else if (t == 3)
+            c[i] = r % (lim * 40) - lim * 20;
+        else
+            c[i] = r % lim;
+    }
+    if (t == 2) {
+        if (c[0] & 1) c[3] = c[1]; else c[2] = c[0];
+    }
+}
+
+static void ICACHE_FLASH_ATTR cmd_linebench(void)
+{
+    static const char *const names[] = { "short   ", "long    ", "h/v     ", "offscrn " };
+
+    uint8_t *fb = fb_buffer();          /* also stops display list recording */
+    uint8_t *ref = (uint8_t *)heap_alloc(FB_SIZE);
+    if (!ref) { uart_puts("no memory\n"); return; }
+
+    uart_puts("linebench: ");
+    uart_put_dec(BENCH_LINES);
+    uart_puts(" lines per set, cycles/line\n");
+    for (int t = 0; t < 4; t++) {
+        int c[4];
+        uint32_t seed;
+
+        fb_clear();
+        seed = (uint32_t)t + 1;
+        uint32_t t0 = get_ccount();
+        for (int i = 0; i < BENCH_LINES; i++) {
+            bench_coords(t, &seed, c);
+            ref_line(c[0], c[1], c[2], c[3]);
+        }
+        uint32_t c_ref = get_ccount() - t0;
+        ets_memcpy(ref, fb, FB_SIZE);
+
+        fb_clear();
+        seed = (uint32_t)t + 1;
+        t0 = get_ccount();
+        for (int i = 0; i < BENCH_LINES; i++) {
+            bench_coords(t, &seed, c);
+            fb_line(c[0], c[1], c[2], c[3]);
+        }
+        uint32_t c_new = get_ccount() - t0;
+
+        int same = 1;
+        for (int i = 0; i < FB_SIZE; i++)
+            if (fb[i] != ref[i]) same = 0;
+
+        uart_puts("  ");
+        uart_puts(names[t]);
+        uart_puts("per-pixel ");
+        uart_put_dec(c_ref / BENCH_LINES);
+        uart_puts("  fb_line ");
+        uart_put_dec(c_new / BENCH_LINES);
+        uart_puts("  (");
+        uint32_t x10 = c_new ? c_ref * 10 / c_new : 0;
+        uart_put_dec(x10 / 10);
+        uart_putc('.');
+        uart_put_dec(x10 % 10);
+        uart_puts(same ? "x)\n" : "x)  PIXELS DIFFER\n");
+    }
+    heap_free(ref);
+    fb_flush();
+}
+
+/* ====== textbench: glyph blitter against per-pixel text ====== */
+
+#define BENCH_CHARS 128
+
+/* fb_putchar() as it was: one fb_set_pixel per lit pixel */
+static void ICACHE_FLASH_ATTR ref_char(int x, int y, char c)
+{
+    const uint8_t *glyph = font_4x6[c - FONT_FIRST];
+    for (int row = 0; row < FONT_H; row++)
+        for (int col = 0; col < FONT_W; col++)
+            if (glyph[row] & (0x80 >> col))
+                fb_set_pixel(x + col, y + row);
+}
+
+/* Position of char i in set t: text grid, odd x, over the edges */
+static void ICACHE_FLASH_ATTR bench_pos(int t, int i, int *x, int *y)
+{
+    if (t == 0) {
+        *x = (i % TEXT_COLS) * FONT_W;
+        *y = (i / TEXT_COLS) * FONT_H;
+    } else if (t == 1) {
+        *x = (i % 30) * FONT_W + 1 + (i & 2);
+        *y = (i / 30) * (FONT_H + 1) + 1;
+    } else {
+        *x = (i & 1) ? FB_WIDTH - 2 - (i & 3) : -2 + (i & 2);
+        *y = (i * 5) % (FB_HEIGHT + 4) - 3;
+    }
+}
+
+static void ICACHE_FLASH_ATTR cmd_textbench(void)
+{
+    static const char *const names[] = { "grid    ", "odd x   ", "edges   " };
+
+    uint8_t *fb = fb_buffer();          /* also stops display list recording */
+    uint8_t *ref = (uint8_t *)heap_alloc(FB_SIZE);
+    if (!ref) { uart_puts("no memory\n"); return; }
+
+    uart_puts("textbench: ");
+    uart_put_dec(BENCH_CHARS);
+    uart_puts(" chars per set, cycles/char\n");
+    for (int t = 0; t < 3; t++) {
+        int x, y;
+
+        fb_clear();
+        uint32_t t0 = get_ccount();
+        for (int i = 0; i < BENCH_CHARS; i++) {
+            bench_pos(t, i, &x, &y);
+            ref_char(x, y, (char)(FONT_FIRST + 1 + i % (FONT_GLYPHS - 1)));
+        }
+        uint32_t c_ref = get_ccount() - t0;
+        ets_memcpy(ref, fb, FB_SIZE);
+
+        fb_clear();
+        t0 = get_ccount();
+        for (int i = 0; i < BENCH_CHARS; i++) {
+            bench_pos(t, i, &x, &y);
+            fb_putchar(x, y, (char)(FONT_FIRST + 1 + i % (FONT_GLYPHS - 1)));
+        }
+        uint32_t c_new = get_ccount() - t0;
+
+        int same = 1;
+        for (int i = 0; i < FB_SIZE; i++)
+            if (fb[i] != ref[i]) same = 0;
+
+        uart_puts("  ");
+        uart_puts(names[t]);
+        uart_puts("per-pixel ");
+        uart_put_dec(c_ref / BENCH_CHARS);
+        uart_puts("  fb_putchar ");
+        uart_put_dec(c_new / BENCH_CHARS);
+        uart_puts("  (");
+        uint32_t x10 = c_new ? c_ref * 10 / c_new : 0;
+        uart_put_dec(x10 / 10);
+        uart_putc('.');
+        uart_put_dec(x10 % 10);
+        uart_puts(same ? "x)\n" : "x)  PIXELS DIFFER\n");
+    }
+    heap_free(ref);
+    fb_flush();
+}
+
+/* Benchmarks live in flash (ICACHE_FLASH_ATTR); keep the flash task
+ * off the bus while they run */
+static void run_from_flash(void (*fn)(void))
+{
+    flashio_code_lock();
+    fn();
+    flashio_code_unlock();
+}
+#endif /* OSITO_BENCH */
+
 static void cmd_fbtest(void)
 {
     uart_puts("fb: drawing test pattern...\n");
@@ -789,12 +1245,20 @@ static void process_command(const char *cmd)
         cmd_adc();
     else if (ets_strcmp(cmd, "fbtest") == 0)
         cmd_fbtest();
+    else if (ets_strncmp(cmd, "video", 5) == 0 && (cmd[5] == ' ' || cmd[5] == '\0'))
+        cmd_video(cmd + 5);
     else if (ets_strcmp(cmd, "forth") == 0)
         forth_enter();
+#if OSITO_BENCH
+    else if (ets_strcmp(cmd, "linebench") == 0)
+        run_from_flash(cmd_linebench);
+    else if (ets_strcmp(cmd, "textbench") == 0)
+        run_from_flash(cmd_textbench);
     else if (ets_strcmp(cmd, "fixtest") == 0)
-        fix_test();
+        run_from_flash(fix_test);
     else if (ets_strcmp(cmd, "mat3test") == 0)
-        mat3_test();
+        run_from_flash(mat3_test);
+#endif
     else if (ets_strcmp(cmd, "wiretest") == 0)
         wire_test();
     else if (ets_strcmp(cmd, "wirespin") == 0)
@@ -803,8 +1267,14 @@ static void process_command(const char *cmd)
         cmd_ship(cmd + 4);
     else if (ets_strcmp(cmd, "shipspin") == 0)
         cmd_shipspin();
+    else if (ets_strncmp(cmd, "model", 5) == 0 && (cmd[5] == ' ' || cmd[5] == '\0'))
+        cmd_model(cmd + 5);
     else if (ets_strcmp(cmd, "elite") == 0)
         game_elite();
+#if OSITO_FBREC
+    else if (ets_strncmp(cmd, "rec", 3) == 0 && (cmd[3] == ' ' || cmd[3] == '\0'))
+        cmd_rec(cmd + 3);
+#endif
     else if (ets_strcmp(cmd, "uname") == 0)
         cmd_uname();
     else if (ets_strcmp(cmd, "reboot") == 0)
@@ -818,6 +1288,65 @@ static void process_command(const char *cmd)
 
 /* ====== Shell task ====== */
 
+/*
+ * Tab: complete the word under the cursor as a file path. One match is
+ * filled in (with '/' after a directory); several are extended to their
+ * common prefix, or listed when there is nothing more to add.
+ */
+static void complete_path(void)
+{
+    int start = cmd_pos;
+    while (start > 0 && cmd_buf[start - 1] != ' ') start--;
+    if (start == 0 || !fs_mounted())
+        return;                         /* command names aren't paths */
+
+    cmd_buf[cmd_pos] = '\0';
+    const char *word = cmd_buf + start;
+    if (*word == '/') word++;           /* fs_readdir paths have no '/' */
+    int typed = str_len(word);
+
+    fs_dir_t d;
+    fs_dirinfo_t info;
+    char first[FS_PATH_LEN];
+    int common = 0, count = 0, is_dir = 0;
+    if (fs_opendir(&d, word) < 0)
+        return;
+    while (fs_readdir(&d, &info) > 0) {
+        if (count++ == 0) {
+            ets_memcpy(first, info.name, FS_PATH_LEN);
+            common = str_len(first);
+            is_dir = info.type == FS_TYPE_DIR;
+        } else {
+            int i = typed;
+            while (i < common && first[i] == info.name[i]) i++;
+            common = i;
+        }
+    }
+    if (count == 0)
+        return;
+
+    uart_lock();
+    if (count > 1 && common == typed) {
+        /* Ambiguous: show the candidates and redraw the line */
+        uart_puts("\n");
+        fs_opendir(&d, word);
+        while (fs_readdir(&d, &info) > 0) {
+            uart_puts(info.name);
+            uart_puts(info.type == FS_TYPE_DIR ? "/  " : "  ");
+        }
+        uart_puts("\nosito> ");
+        uart_puts(cmd_buf);
+    } else {
+        if (count == 1)
+            first[common++] = is_dir ? '/' : ' ';
+        for (int i = typed; i < common && cmd_pos < CMD_BUF_SIZE - 1; i++) {
+            cmd_buf[cmd_pos++] = first[i];
+            uart_putc(first[i]);
+        }
+    }
+    uart_unlock();
+}
+
 void shell_task(void *arg)
 {
     (void)arg;
@@ -847,6 +1376,9 @@ void shell_task(void *arg)
                 uart_puts("\b \b"); /* Erase character on terminal */
             }
         }
+        else if (c == '\t') {
+            complete_path();
+        }
         else if (cmd_pos < CMD_BUF_SIZE - 1) {
             cmd_buf[cmd_pos++] = (char)c;
             uart_putc((char)c); /* Echo */
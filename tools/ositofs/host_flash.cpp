@@ -0,0 +1,319 @@
+/*
+ * OsitoFS host tool - file-backed SPI flash emulator
+ *
+ * Stands in for the ESP8266 mask ROM and the kernel services used by
+ * the filesystem. Everything is single-threaded: irq_save() is a no-op
+ * (see OSITO_HOST in kernel/types.h) and task_yield() returns at once.
+ */
+
+#include "host_flash.h"
+#include "kernel/mq.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+extern "C" {
+
+static uint8_t flash[HOST_FLASH_SIZE];
+static hostflash_stats_t stats;
+static int verbose = 1;
+
+/* ====== Image I/O ====== */
+
+void hostflash_erase_all(void)
+{
+    memset(flash, 0xFF, sizeof(flash));
+}
+
+int hostflash_load(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) return -1;
+
+    hostflash_erase_all();
+    size_t max = FS_FLASH_END - FS_FLASH_BASE;
+    size_t got = fread(flash + FS_FLASH_BASE, 1, max, f);
+    fclose(f);
+    return got > 0 ? 0 : -1;
+}
+
+int hostflash_save(const char *path, int trim)
+{
+    uint32_t end = FS_FLASH_END;
+
+    if (trim) {
+        /* Drop trailing erased sectors, they are 0xFF on a fresh chip
+         * and get erased before use anyway. Keep at least the metadata. */
+        while (end > FS_FLASH_BASE + 2 * FS_SECTOR_SIZE) {
+            const uint8_t *s = flash + end - FS_SECTOR_SIZE;
+            uint32_t i = 0;
+            while (i < FS_SECTOR_SIZE && s[i] == 0xFF) i++;
+            if (i < FS_SECTOR_SIZE) break;
+            end -= FS_SECTOR_SIZE;
+        }
+    }
+
+    FILE *f = fopen(path, "wb");
+    if (!f) return -1;
+    size_t len = end - FS_FLASH_BASE;
+    size_t put = fwrite(flash + FS_FLASH_BASE, 1, len, f);
+    fclose(f);
+    return put == len ? (int)len : -1;
+}
+
+/* ====== Statistics ====== */
+
+hostflash_stats_t *hostflash_stats(void)
+{
+    return &stats;
+}
+
+void hostflash_reset_stats(void)
+{
+    memset(&stats, 0, sizeof(stats));
+}
+
+/*
+ * Rough Winbond W25Q32 figures (the Wemos D1 part):
+ *   read    40MHz DOUT = 10 bytes/us, ~2us command + ROM call overhead
+ *   program 0.7ms typical per 256-byte page
+ *   erase   45ms typical per 4KB sector
+ */
+uint32_t hostflash_estimate_us(const hostflash_stats_t *st)
+{
+    uint64_t us = 0;
+    us += (uint64_t)st->reads * 2 + st->read_bytes / 10;
+    us += (uint64_t)st->writes * 2 + (uint64_t)(st->write_bytes + 255) / 256 * 700;
+    us += (uint64_t)st->erases * 45000;
+    return (uint32_t)us;
+}
+
+void hostflash_set_verbose(int on)
+{
+    verbose = on;
+}
+
+/* ====== ROM SPI flash functions ====== */
+
+/* The ROM routines need 4-byte aligned buffers and sizes; count the
+ * violations so the harness catches them before real hardware does. */
+static int check_args(uint32_t addr, const void *buf, uint32_t size)
+{
+    if (((uintptr_t)buf & 3) || (addr & 3) || (size & 3))
+        stats.unaligned++;
+    if (addr > HOST_FLASH_SIZE || size > HOST_FLASH_SIZE - addr)
+        return -1;
+    return 0;
+}
+
+int SPIRead(uint32_t addr, void *dst, uint32_t size)
+{
+    if (check_args(addr, dst, size) < 0) return 1;
+    stats.reads++;
+    stats.read_bytes += size;
+    memcpy(dst, flash + addr, size);
+    return 0;
+}
+
+int SPIWrite(uint32_t addr, const void *src, uint32_t size)
+{
+    if (check_args(addr, src, size) < 0) return 1;
+    stats.writes++;
+    stats.write_bytes += size;
+
+    const uint8_t *s = (const uint8_t *)src;
+    int over = 0;
+    for (uint32_t i = 0; i < size; i++) {
+        uint8_t old = flash[addr + i];
+        if (s[i] & ~old) over = 1;
+        flash[addr + i] = old & s[i];   /* NOR: program clears bits only */
+    }
+    if (over) stats.overprogram++;
+    return 0;
+}
+
+int SPIEraseSector(int sector)
+{
+    uint32_t addr = (uint32_t)sector * FS_SECTOR_SIZE;
+    if (sector < 0 || addr >= HOST_FLASH_SIZE) return 1;
+    stats.erases++;
+    memset(flash + addr, 0xFF, FS_SECTOR_SIZE);
+    return 0;
+}
+
+/* ====== ROM memory functions ====== */
+
+void *ets_memset(void *dst, int c, size_t n)
+{
+    return memset(dst, c, n);
+}
+
+void *ets_memcpy(void *dst, const void *src, size_t n)
+{
+    return memcpy(dst, src, n);
+}
+
+void *ets_memmove(void *dst, const void *src, size_t n)
+{
+    return memmove(dst, src, n);
+}
+
+/* ====== ROM flash cache (nothing is flash-mapped on the host) ====== */
+
+void Cache_Read_Enable(uint32_t odd_even, uint32_t mb_count, uint32_t autoload)
+{
+}
+
+void Cache_Read_Disable(void)
+{
+}
+
+/* ====== UART (filesystem messages go to stderr) ====== */
+
+void uart_putc(char c)
+{
+    if (verbose) fputc(c, stderr);
+}
+
+void uart_puts(const char *s)
+{
+    if (verbose) fputs(s, stderr);
+}
+
+void uart_put_dec(uint32_t val)
+{
+    if (verbose) fprintf(stderr, "%u", (unsigned)val);
+}
+
+void uart_put_hex(uint32_t val)
+{
+    if (verbose) fprintf(stderr, "0x%08x", (unsigned)val);
+}
+
+int uart_getc(void)
+{
+    return -1;
+}
+
+/* ====== Kernel ====== */
+
+static uint32_t fake_ticks;
+
+uint32_t get_tick_count(void)
+{
+    return fake_ticks++;
+}
+
+void task_yield(void)
+{
+}
+
+void task_delay_ticks(uint32_t ticks)
+{
+    fake_ticks += ticks;
+}
+
+/* Single-threaded: a semaphore never has to block, and the flash I/O
+ * task never starts, so its queue is never used (requests run inline). */
+void sem_init(sem_t *s, int32_t initial_count)
+{
+    s->count = initial_count;
+    s->num_waiters = 0;
+}
+
+void sem_wait(sem_t *s)
+{
+    s->count--;
+}
+
+int sem_trywait(sem_t *s)
+{
+    if (s->count <= 0) return -1;
+    s->count--;
+    return 0;
+}
+
+void sem_post(sem_t *s)
+{
+    s->count++;
+}
+
+void mutex_init(mutex_t *m)
+{
+    sem_init(&m->sem, 1);
+}
+
+void mutex_lock(mutex_t *m)
+{
+    sem_wait(&m->sem);
+}
+
+void mutex_unlock(mutex_t *m)
+{
+    sem_post(&m->sem);
+}
+
+void rwlock_init(rwlock_t *rw)
+{
+    rw->readers = 0;
+}
+
+void rwlock_read_lock(rwlock_t *rw)
+{
+    rw->readers++;
+}
+
+void rwlock_read_unlock(rwlock_t *rw)
+{
+    rw->readers--;
+}
+
+void rwlock_write_lock(rwlock_t *rw)
+{
+    (void)rw;
+}
+
+void rwlock_write_unlock(rwlock_t *rw)
+{
+    (void)rw;
+}
+
+void mq_init(mq_t *q, void *buf, uint16_t msg_size, uint16_t capacity)
+{
+    q->buf = (uint8_t *)buf;
+    q->msg_size = msg_size;
+    q->capacity = capacity;
+    q->head = 0;
+    q->tail = 0;
+}
+
+void mq_send(mq_t *q, const void *msg)
+{
+    (void)q;
+    (void)msg;
+}
+
+void mq_recv(mq_t *q, void *msg)
+{
+    (void)q;
+    (void)msg;
+}
+
+uint16_t mq_count(mq_t *q)
+{
+    (void)q;
+    return 0;
+}
+
+void *heap_alloc(uint32_t size)
+{
+    return malloc(size);
+}
+
+void heap_free(void *ptr)
+{
+    free(ptr);
+}
+
+} /* extern "C" */
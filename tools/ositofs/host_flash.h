@@ -0,0 +1,58 @@
+/*
+ * OsitoFS host tool - file-backed SPI flash emulator
+ *
+ * Provides the ROM SPI functions (SPIRead, SPIWrite, SPIEraseSector)
+ * and the handful of kernel/UART symbols that src/fs/ositofs.cpp links
+ * against, so the real filesystem code runs unmodified on the host.
+ *
+ * The emulated part is a 4MB NOR flash: erase sets a 4KB sector to 0xFF,
+ * program can only clear bits (new = old & data), exactly like the chip.
+ */
+#ifndef OSITOFS_HOST_FLASH_H
+#define OSITOFS_HOST_FLASH_H
+
+#include "osito.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HOST_FLASH_SIZE  FS_FLASH_END   /* 4MB, whole chip */
+
+/* SPI operation counters (reset with hostflash_reset_stats) */
+typedef struct {
+    uint32_t reads;          /* SPIRead calls */
+    uint32_t read_bytes;
+    uint32_t writes;         /* SPIWrite calls */
+    uint32_t write_bytes;
+    uint32_t erases;         /* SPIEraseSector calls */
+    uint32_t unaligned;      /* calls violating the ROM 4-byte rules */
+    uint32_t overprogram;    /* writes that tried to set 0 -> 1 bits */
+} hostflash_stats_t;
+
+/* Fill the whole chip with 0xFF (fresh erased part) */
+void hostflash_erase_all(void);
+
+/* Load an OsitoFS image (as flashed at FS_FLASH_BASE). Returns 0 on success. */
+int hostflash_load(const char *path);
+
+/* Save the filesystem region. trim != 0 drops trailing erased sectors.
+ * Returns the number of bytes written, or -1 on error. */
+int hostflash_save(const char *path, int trim);
+
+/* Operation counters */
+hostflash_stats_t *hostflash_stats(void);
+void hostflash_reset_stats(void);
+
+/* Estimated time (microseconds) the counted operations would take on
+ * the Wemos D1 flash (40MHz DOUT, typical 4KB erase and page program). */
+uint32_t hostflash_estimate_us(const hostflash_stats_t *st);
+
+/* UART stub: 1 = print filesystem messages to stderr (default), 0 = quiet */
+void hostflash_set_verbose(int on);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OSITOFS_HOST_FLASH_H */
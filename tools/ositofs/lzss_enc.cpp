@@ -0,0 +1,76 @@
+/*
+ * OsitoFS host tool - LZSS encoder
+ *
+ * Mirrors the decoder in src/fs/lzss.cpp. Speed is irrelevant here,
+ * so the match search is a plain scan of the window.
+ */
+
+#include "lzss_enc.h"
+#include "fs/lzss.h"
+
+namespace {
+
+struct BitWriter {
+    std::vector<uint8_t> out;
+    uint32_t acc = 0;
+    int nbits = 0;
+
+    void put(uint32_t v, int n)
+    {
+        acc = (acc << n) | (v & ((1u << n) - 1));
+        nbits += n;
+        while (nbits >= 8) {
+            nbits -= 8;
+            out.push_back((uint8_t)(acc >> nbits));
+        }
+        acc &= (1u << nbits) - 1;
+    }
+
+    void flush()
+    {
+        if (nbits)
+            out.push_back((uint8_t)(acc << (8 - nbits)));
+        nbits = 0;
+        acc = 0;
+    }
+};
+
+} /* namespace */
+
+std::vector<uint8_t> lzss_encode(const uint8_t *data, size_t len)
+{
+    BitWriter bw;
+    size_t pos = 0;
+
+    while (pos < len) {
+        size_t best_len = 0, best_dist = 0;
+        size_t max_len = len - pos < LZSS_MAX_MATCH ? len - pos : LZSS_MAX_MATCH;
+        size_t max_dist = pos < LZSS_WINDOW ? pos : LZSS_WINDOW;
+
+        for (size_t dist = 1; dist <= max_dist; dist++) {
+            size_t l = 0;
+            /* Overlapping copies are fine: the decoder copies byte by byte */
+            while (l < max_len && data[pos + l] == data[pos + l - dist])
+                l++;
+            if (l > best_len) {
+                best_len = l;
+                best_dist = dist;
+                if (l == max_len) break;
+            }
+        }
+
+        if (best_len >= LZSS_MIN_MATCH) {
+            bw.put(0, 1);
+            bw.put((uint32_t)(best_dist - 1), 8);
+            bw.put((uint32_t)(best_len - LZSS_MIN_MATCH), 4);
+            pos += best_len;
+        } else {
+            bw.put(1, 1);
+            bw.put(data[pos], 8);
+            pos++;
+        }
+    }
+
+    bw.flush();
+    return bw.out;
+}
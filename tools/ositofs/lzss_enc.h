@@ -0,0 +1,17 @@
+/*
+ * OsitoFS host tool - LZSS encoder
+ *
+ * Produces the stream decoded by src/fs/lzss.cpp (format in lzss.h).
+ * Greedy longest match over the 256-byte window.
+ */
+#ifndef OSITOFS_LZSS_ENC_H
+#define OSITOFS_LZSS_ENC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+std::vector<uint8_t> lzss_encode(const uint8_t *data, size_t len);
+
+#endif /* OSITOFS_LZSS_ENC_H */
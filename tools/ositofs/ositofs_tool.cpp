@@ -0,0 +1,473 @@
+/*
+ * OsitoFS host tool - offline image builder, lister and extractor
+ *
+ * Links the real src/fs/ositofs.cpp against an emulated SPI flash
+ * (host_flash.cpp), so images are produced by exactly the code that
+ * will read them on the device.
+ *
+ * Usage:
+ *   ositofs build   IMAGE DIR           format + pack DIR (one subdir level)
+ *   ositofs ls      IMAGE               list files
+ *   ositofs extract IMAGE OUTDIR [NAME]...
+ *   ositofs add     IMAGE FILE [NAME]   add/replace one file
+ *   ositofs rm      IMAGE NAME          delete one file
+ *   ositofs bench   [NFILES]            filesystem workload, SPI op counts
+ *
+ * Options (before the command):
+ *   -q          quiet (suppress filesystem console messages)
+ *   -z          store files LZSS-compressed when that saves space
+ *   --no-trim   write the full 3840KB region instead of trimming
+ *   --cache BYTES[:PAGE]  enable the flash read cache (as on the device)
+ *
+ * Flash the result with:
+ *   esptool.py --chip esp8266 --baud 460800 write_flash 0x40000 IMAGE
+ */
+
+#include "host_flash.h"
+#include "lzss_enc.h"
+#include "fs/ositofs.h"
+#include "fs/fcache.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace stdfs = std::filesystem;
+
+static int trim = 1;
+static int compress = 0;
+static uint64_t total_raw = 0, total_stored = 0;
+
+/* ====== Helpers ====== */
+
+static bool read_host_file(const stdfs::path &p, std::vector<uint8_t> &out)
+{
+    std::ifstream f(p, std::ios::binary);
+    if (!f) return false;
+    out.assign(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+    return true;
+}
+
+static bool write_host_file(const stdfs::path &p, const uint8_t *data, size_t len)
+{
+    std::ofstream f(p, std::ios::binary);
+    if (!f) return false;
+    f.write((const char *)data, (std::streamsize)len);
+    return (bool)f;
+}
+
+static int mount(const char *image)
+{
+    if (hostflash_load(image) < 0) {
+        fprintf(stderr, "ositofs: cannot read image '%s'\n", image);
+        return -1;
+    }
+    if (fs_init() < 0) {
+        fprintf(stderr, "ositofs: '%s' is not an OsitoFS image\n", image);
+        return -1;
+    }
+    return 0;
+}
+
+static int save(const char *image)
+{
+    int len = hostflash_save(image, trim);
+    if (len < 0) {
+        fprintf(stderr, "ositofs: cannot write image '%s'\n", image);
+        return -1;
+    }
+    printf("%s: %d bytes (%d sectors), flash at 0x%x\n",
+           image, len, len / FS_SECTOR_SIZE, FS_FLASH_BASE);
+    return 0;
+}
+
+/* Paths of all files on the mounted volume ("name" or "dir/name") */
+static std::vector<std::string> list_names(void)
+{
+    std::vector<std::string> names;
+    fs_dir_t d;
+    fs_dirinfo_t info;
+    if (fs_opendir(&d, nullptr) < 0)
+        return names;
+    while (fs_readdir(&d, &info) > 0)
+        if (info.type == FS_TYPE_FILE)
+            names.push_back(info.name);
+    if (fs_version() == 2)
+        std::sort(names.begin(), names.end());
+    return names;
+}
+
+static int add_file(const stdfs::path &src, const std::string &name)
+{
+    std::vector<uint8_t> data;
+    if (!read_host_file(src, data)) {
+        fprintf(stderr, "ositofs: cannot read '%s'\n", src.string().c_str());
+        return -1;
+    }
+    if (name.empty() || name.size() >= FS_PATH_LEN) {
+        fprintf(stderr, "ositofs: bad name '%s' (max %d chars per component)\n",
+                name.c_str(), FS_NAME_LEN - 1);
+        return -1;
+    }
+    if (data.empty()) {
+        fprintf(stderr, "ositofs: skipping empty file '%s'\n", name.c_str());
+        return 0;
+    }
+
+    /* Compress only when it saves at least one 256-byte fragment unit */
+    std::vector<uint8_t> packed;
+    if (compress)
+        packed = lzss_encode(data.data(), data.size());
+    bool use_packed = compress &&
+        (packed.size() + FS_FRAG_UNIT - 1) / FS_FRAG_UNIT <
+        (data.size() + FS_FRAG_UNIT - 1) / FS_FRAG_UNIT;
+
+    int rc;
+    if (use_packed) {
+        fs_delete(name.c_str());
+        rc = fs_create_packed(name.c_str(), packed.data(), (uint32_t)packed.size(),
+                              (uint32_t)data.size());
+    } else {
+        rc = fs_overwrite(name.c_str(), data.data(), (uint32_t)data.size());
+    }
+    if (rc < 0) {
+        fprintf(stderr, "ositofs: failed to store '%s'\n", name.c_str());
+        return -1;
+    }
+
+    size_t stored = use_packed ? packed.size() : data.size();
+    total_raw += data.size();
+    total_stored += stored;
+    if (use_packed)
+        printf("  %-32s %7zu  z %7zu (%zu%%)\n", name.c_str(), data.size(),
+               stored, stored * 100 / data.size());
+    else
+        printf("  %-32s %7zu\n", name.c_str(), data.size());
+    return 0;
+}
+
+/* ====== Commands ====== */
+
+/* Regular files directly in dir, sorted; subdirectories into *subdirs */
+static int scan_host_dir(const stdfs::path &dir, std::vector<stdfs::path> &files,
+                         std::vector<stdfs::path> *subdirs)
+{
+    std::error_code ec;
+    for (const auto &de : stdfs::directory_iterator(dir, ec)) {
+        if (de.is_regular_file())
+            files.push_back(de.path());
+        else if (subdirs && de.is_directory())
+            subdirs->push_back(de.path());
+    }
+    if (ec) {
+        fprintf(stderr, "ositofs: cannot read directory '%s'\n", dir.string().c_str());
+        return -1;
+    }
+    std::sort(files.begin(), files.end());
+    if (subdirs) std::sort(subdirs->begin(), subdirs->end());
+    return 0;
+}
+
+static int cmd_build(const char *image, const char *dir)
+{
+    std::vector<stdfs::path> files, subdirs;
+    if (scan_host_dir(dir, files, &subdirs) < 0)
+        return 1;
+
+    hostflash_erase_all();
+    fs_format();
+
+    int failed = 0;
+    size_t total = files.size();
+    for (const auto &p : files) {
+        if (add_file(p, p.filename().string()) < 0)
+            failed++;
+    }
+
+    /* One level of subdirectories, matching the filesystem */
+    for (const auto &d : subdirs) {
+        std::string dname = d.filename().string();
+        std::vector<stdfs::path> sub;
+        if (scan_host_dir(d, sub, nullptr) < 0 || fs_mkdir(dname.c_str()) < 0) {
+            fprintf(stderr, "ositofs: cannot create directory '%s'\n", dname.c_str());
+            failed++;
+            continue;
+        }
+        total += sub.size();
+        for (const auto &p : sub) {
+            if (add_file(p, dname + "/" + p.filename().string()) < 0)
+                failed++;
+        }
+    }
+
+    printf("%zu files, %u bytes free\n", total - failed, fs_free());
+    if (compress && total_raw)
+        printf("compressed %llu -> %llu bytes (%llu%%)\n",
+               (unsigned long long)total_raw, (unsigned long long)total_stored,
+               (unsigned long long)(total_stored * 100 / total_raw));
+    if (save(image) < 0) return 1;
+    return failed ? 1 : 0;
+}
+
+static int cmd_ls(const char *image)
+{
+    if (mount(image) < 0) return 1;
+
+    std::vector<std::string> names = list_names();
+    printf("Name                             Size  Stored\n");
+    for (const auto &n : names) {
+        fs_file_t f;
+        fs_open(&f, n.c_str());
+        printf("%-32s %5u  %5u%s\n", n.c_str(), f.size, f.stored,
+               f.flags & FS_F_COMPRESSED ? " z" : "");
+    }
+    printf("%zu files, %u bytes free\n", names.size(), fs_free());
+    return 0;
+}
+
+static int cmd_extract(const char *image, const char *outdir, int argc, char **argv)
+{
+    if (mount(image) < 0) return 1;
+
+    std::vector<std::string> names;
+    if (argc > 0) {
+        for (int i = 0; i < argc; i++) names.push_back(argv[i]);
+    } else {
+        names = list_names();
+    }
+
+    stdfs::create_directories(outdir);
+    int failed = 0;
+    for (const auto &n : names) {
+        int size = fs_stat(n.c_str());
+        if (size < 0) {
+            fprintf(stderr, "ositofs: not found: %s\n", n.c_str());
+            failed++;
+            continue;
+        }
+        std::vector<uint8_t> buf((size_t)size);
+        int got = fs_read(n.c_str(), buf.data(), (uint32_t)size);
+        stdfs::path dst = stdfs::path(outdir) / n;
+        stdfs::create_directories(dst.parent_path());
+        if (got != size || !write_host_file(dst, buf.data(), (size_t)got)) {
+            fprintf(stderr, "ositofs: failed to extract %s\n", n.c_str());
+            failed++;
+            continue;
+        }
+        printf("  %-32s %7d\n", n.c_str(), got);
+    }
+    return failed ? 1 : 0;
+}
+
+static int cmd_add(const char *image, const char *file, const char *name)
+{
+    if (mount(image) < 0) return 1;
+    std::string n = name ? name : stdfs::path(file).filename().string();
+    if (add_file(file, n) < 0) return 1;
+    return save(image) < 0 ? 1 : 0;
+}
+
+static int cmd_rm(const char *image, const char *name)
+{
+    if (mount(image) < 0) return 1;
+    if (fs_delete(name) < 0) {
+        fprintf(stderr, "ositofs: not found: %s\n", name);
+        return 1;
+    }
+    return save(image) < 0 ? 1 : 0;
+}
+
+/* ====== Benchmark harness ====== */
+
+/*
+ * Runs a script-heavy workload against a freshly formatted volume and
+ * reports SPI traffic per phase, plus the flash time it would cost on
+ * the device. Used to compare filesystem changes, not absolute speed.
+ */
+
+static void bench_report(const char *phase, int ops)
+{
+    hostflash_stats_t *st = hostflash_stats();
+    uint32_t us = hostflash_estimate_us(st);
+    printf("%-8s %5d %7u %9u %6u %9u %6u %9.1f %9u%s\n",
+           phase, ops, st->reads, st->read_bytes, st->writes, st->write_bytes,
+           st->erases, us / 1000.0, ops ? us / (uint32_t)ops : 0,
+           st->unaligned || st->overprogram ? "  !" : "");
+    hostflash_reset_stats();
+}
+
+static int cmd_bench(int nfiles)
+{
+    /* Small scripts dominate real volumes; mix in some larger assets */
+    static const uint32_t sizes[] = { 29, 180, 700, 1500, 5000 };
+    const int nsizes = sizeof(sizes) / sizeof(sizes[0]);
+
+    static uint8_t data[8192] __attribute__((aligned(4)));
+    static uint8_t buf[8192] __attribute__((aligned(4)));
+    for (uint32_t i = 0; i < sizeof(data); i++)
+        data[i] = (uint8_t)(i * 7 + (i >> 5));
+
+    hostflash_set_verbose(0);
+    hostflash_erase_all();
+    fs_format();
+    hostflash_reset_stats();
+
+    printf("phase      ops   reads  rd bytes writes  wr bytes erases    est ms  us/op\n");
+
+    char name[FS_PATH_LEN];
+    int created = 0;
+    for (int i = 0; i < nfiles; i++) {
+        snprintf(name, sizeof(name), "f%04d.zf", i);
+        if (fs_create(name, data, sizes[i % nsizes]) < 0)
+            break;
+        created++;
+    }
+    bench_report("create", created);
+
+    for (int i = 0; i < created; i++) {
+        snprintf(name, sizeof(name), "f%04d.zf", i);
+        fs_stat(name);
+    }
+    bench_report("stat", created);
+
+    int bad = 0;
+    for (int i = 0; i < created; i++) {
+        snprintf(name, sizeof(name), "f%04d.zf", i);
+        uint32_t len = sizes[i % nsizes];
+        if (fs_read(name, buf, len) != (int)len || memcmp(buf, data, len) != 0)
+            bad++;
+    }
+    bench_report("read", created);
+
+    /* Scripts are consumed in small chunks, and a few are loaded often */
+    fs_file_t f;
+    int streamed = 0;
+    for (int i = 0; i < created; i++) {
+        snprintf(name, sizeof(name), "f%04d.zf", (i * 7) % 16);
+        if (fs_open(&f, name) < 0)
+            continue;
+        uint32_t got = 0;
+        int n;
+        while ((n = fs_fread(&f, buf + got, 64)) > 0)
+            got += n;
+        if (got != sizes[((i * 7) % 16) % nsizes] || memcmp(buf, data, got) != 0)
+            bad++;
+        streamed++;
+    }
+    bench_report("stream", streamed);
+
+    /* The same few small scripts, loaded over and over */
+    static const int hot[] = { 0, 1, 5, 6 };
+    int loaded = 0;
+    for (int i = 0; i < created && created > 6; i++) {
+        int k = hot[i & 3];
+        snprintf(name, sizeof(name), "f%04d.zf", k);
+        if (fs_open(&f, name) < 0)
+            continue;
+        int n = fs_fread(&f, buf, 64);
+        while (n > 0)
+            n = fs_fread(&f, buf, 64);
+        loaded++;
+    }
+    bench_report("hot", loaded);
+
+    int appended = 0;
+    for (int i = 0; i < created; i++) {
+        snprintf(name, sizeof(name), "f%04d.zf", i);
+        if (fs_append(name, data, 16) == 0)
+            appended++;
+    }
+    bench_report("append", appended);
+
+    uint32_t free_bytes = fs_free();
+
+    for (int i = 0; i < created; i++) {
+        snprintf(name, sizeof(name), "f%04d.zf", i);
+        fs_delete(name);
+    }
+    bench_report("delete", created);
+
+    printf("%d/%d files created, %u bytes free when full, %d read errors\n",
+           created, nfiles, free_bytes, bad);
+    if (fcache_pages()) {
+        fcache_stats_t *cs = fcache_stats();
+        printf("cache %ux%u: %u hits, %u misses, %u read-ahead, "
+               "%u invalidated, %u bypassed\n",
+               fcache_pages(), fcache_page_size(), cs->hits, cs->misses,
+               cs->readahead, cs->invalidated, cs->bypass);
+    }
+    return bad ? 1 : 0;
+}
+
+/* ====== Main ====== */
+
+static void usage(void)
+{
+    fprintf(stderr,
+        "usage: ositofs [-q] [-z] [--no-trim] [--cache BYTES[:PAGE]] COMMAND ...\n"
+        "  build   IMAGE DIR            format + pack DIR (one subdir level)\n"
+        "  ls      IMAGE                list files\n"
+        "  extract IMAGE OUTDIR [NAME]  extract all (or named) files\n"
+        "  add     IMAGE FILE [NAME]    add or replace one file\n"
+        "  rm      IMAGE NAME           delete one file\n"
+        "  bench   [NFILES]             run filesystem workload (default 100)\n"
+        "flash with: esptool.py --chip esp8266 --baud 460800 write_flash 0x%x IMAGE\n",
+        FS_FLASH_BASE);
+}
+
+int main(int argc, char **argv)
+{
+    int i = 1;
+    for (; i < argc && argv[i][0] == '-'; i++) {
+        if (strcmp(argv[i], "-q") == 0)
+            hostflash_set_verbose(0);
+        else if (strcmp(argv[i], "-z") == 0)
+            compress = 1;
+        else if (strcmp(argv[i], "--no-trim") == 0)
+            trim = 0;
+        else if (strcmp(argv[i], "--cache") == 0 && i + 1 < argc) {
+            char *end;
+            uint32_t bytes = strtoul(argv[++i], &end, 0);
+            uint32_t page = *end == ':' ? strtoul(end + 1, nullptr, 0) : 256;
+            if (fcache_config(bytes, page) < 0) {
+                fprintf(stderr, "bad cache size %s\n", argv[i]);
+                return 2;
+            }
+        }
+        else {
+            usage();
+            return 2;
+        }
+    }
+    if (i >= argc) {
+        usage();
+        return 2;
+    }
+
+    const char *cmd = argv[i++];
+    int nargs = argc - i;
+    char **args = argv + i;
+
+    if (strcmp(cmd, "build") == 0 && nargs == 2)
+        return cmd_build(args[0], args[1]);
+    if (strcmp(cmd, "ls") == 0 && nargs == 1)
+        return cmd_ls(args[0]);
+    if (strcmp(cmd, "extract") == 0 && nargs >= 2)
+        return cmd_extract(args[0], args[1], nargs - 2, args + 2);
+    if (strcmp(cmd, "add") == 0 && (nargs == 2 || nargs == 3))
+        return cmd_add(args[0], args[1], nargs == 3 ? args[2] : nullptr);
+    if (strcmp(cmd, "rm") == 0 && nargs == 2)
+        return cmd_rm(args[0], args[1]);
+    if (strcmp(cmd, "bench") == 0 && nargs <= 1)
+        return cmd_bench(nargs ? atoi(args[0]) : 100);
+
+    usage();
+    return 2;
+}
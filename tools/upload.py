@@ -3,16 +3,22 @@
 OsitoK binary file upload tool.
 
 Protocol:
-  1. Send: fs upload <name> <size>\r\n
+  1. Send: fs upload <name> <size> [raw_size]\r\n
   2. Wait for: READY\n
   3. For each 4096-byte sector:
      a. Send sector data
      b. Wait for '#' ACK
   4. Wait for: OK 0x<crc16>\n
 
+With --compress the file is LZSS-encoded here (same format as
+src/fs/lzss.h) and stored compressed; raw_size tells the device how
+large it is once decoded. Less data crosses the UART, and reads on the
+device decompress transparently.
+
 Usage:
   py tools/upload.py COM4 localfile.bin remotename.bin
   py tools/upload.py COM4 localfile.bin remotename.bin --baud 74880
+  py tools/upload.py COM4 script.zf --compress
 """
 import serial
 import sys
@@ -33,9 +39,70 @@ def crc16_ccitt(data):
     return crc
 
 
+LZSS_WINDOW = 256
+LZSS_MIN_MATCH = 2
+LZSS_MAX_MATCH = 17
+
+
+def lzss_encode(data):
+    """LZSS stream matching src/fs/lzss.h (greedy, 256-byte window)."""
+    out = bytearray()
+    acc = 0
+    nbits = 0
+    heads = {}      # 2-byte prefix -> positions, oldest first
+    pos = 0
+    n = len(data)
+
+    def put(value, bits):
+        nonlocal acc, nbits
+        acc = (acc << bits) | (value & ((1 << bits) - 1))
+        nbits += bits
+        while nbits >= 8:
+            nbits -= 8
+            out.append((acc >> nbits) & 0xFF)
+        acc &= (1 << nbits) - 1
+
+    while pos < n:
+        best_len = 0
+        best_dist = 0
+        max_len = min(LZSS_MAX_MATCH, n - pos)
+        for p in reversed(heads.get(data[pos:pos + 2], ())):
+            dist = pos - p
+            if dist > LZSS_WINDOW:
+                break
+            length = 2
+            while length < max_len and data[p + length] == data[pos + length]:
+                length += 1
+            if length > best_len:
+                best_len, best_dist = length, dist
+                if length == max_len:
+                    break
+
+        if best_len >= LZSS_MIN_MATCH:
+            put(0, 1)
+            put(best_dist - 1, 8)
+            put(best_len - LZSS_MIN_MATCH, 4)
+            step = best_len
+        else:
+            put(1, 1)
+            put(data[pos], 8)
+            step = 1
+
+        for q in range(pos, min(pos + step, n - 1)):
+            lst = heads.setdefault(data[q:q + 2], [])
+            lst.append(q)
+            if len(lst) > 64:
+                del lst[:len(lst) - 64]
+        pos += step
+
+    if nbits:
+        out.append((acc << (8 - nbits)) & 0xFF)
+    return bytes(out)
+
+
 def main():
     if len(sys.argv) < 3:
-        print("Usage: py tools/upload.py <port> <local_file> [remote_name] [--baud N]")
+        print("Usage: py tools/upload.py <port> <local_file> [remote_name] [--baud N] [--compress]")
         print("Example: py tools/upload.py COM4 examples/game.bin")
         print("Remote name defaults to basename of local file.")
         sys.exit(1)
@@ -61,6 +128,17 @@ def main():
         print("Error: file is empty")
         sys.exit(1)
 
+    raw_size = 0
+    if "--compress" in sys.argv:
+        packed = lzss_encode(data)
+        if len(packed) < size:
+            print(f"Compressed: {size} -> {len(packed)} bytes ({len(packed) * 100 // size}%)")
+            raw_size = size
+            data = packed
+            size = len(packed)
+        else:
+            print("Compression doesn't help, sending uncompressed")
+
     print(f"File: {local_file} ({size} bytes)")
     print(f"Remote: {remote_name}")
     print(f"Port: {port} @ {baud} baud")
@@ -82,7 +160,10 @@ def main():
     ser.reset_input_buffer()
 
     # Send upload command
-    cmd = f"fs upload {remote_name} {size}\r"
+    cmd = f"fs upload {remote_name} {size}"
+    if raw_size:
+        cmd += f" {raw_size}"
+    cmd += "\r"
     print(f"Sending: {cmd.strip()}")
     ser.write(cmd.encode("ascii"))
 
@@ -2,8 +2,14 @@
 """
 OsitoK Video Bridge — Renders 128x64 framebuffer from UART in a pygame window.
 
-Protocol: scans serial stream for sync header (0x00 0xFF 0x00 0xFF),
-then reads 1024 bytes as a raw 128x64 1bpp framebuffer.
+Protocol: scans serial stream for a sync header.
+  00 FF 00 FF  key frame: 1024 bytes of raw 128x64 1bpp framebuffer
+  00 FF 00 FE  delta frame: 2-byte length (little endian), then row
+               records: row, first byte << 4 | (bytes - 1), span data
+               with zero runs coded as 00 count (see src/drivers/video.h)
+  00 FF 00 FD  display list: 2-byte length, then line / pixel / text
+               commands, drawn here on a blank frame with the same
+               Bresenham and 4x6 font as the device
 Non-frame bytes are printed to stdout as serial console text.
 Keyboard input is forwarded to serial for shell/game control.
 
@@ -11,6 +17,8 @@ Usage: py tools/viewer.py [COM_PORT] [BAUD]
   Default: COM4, 74880
 """
 
+import os
+import re
 import sys
 import time
 
@@ -34,8 +42,24 @@ SCALE = 4
 WIN_WIDTH = FB_WIDTH * SCALE
 WIN_HEIGHT = FB_HEIGHT * SCALE
 
-# Sync header
+# Sync header (last byte 0xFF = key frame, 0xFE = delta, 0xFD = list)
 SYNC = bytes([0x00, 0xFF, 0x00, 0xFF])
+SYNC_DELTA = 0xFE
+SYNC_LIST = 0xFD
+
+# Display list commands (first byte below 0x80: short line)
+DL_LINE16 = 0x80
+DL_LINE_TO = 0x81
+DL_PIXEL = 0x82
+DL_TEXT = 0x83
+DL_CLIP = 0x84
+DL_ROP = 0x85
+FULL_CLIP = (0, 0, FB_WIDTH - 1, FB_HEIGHT - 1)
+
+FONT_W = 4
+FONT_FIRST = 32
+FONT_SRC = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                        "..", "src", "drivers", "font.cpp")
 
 # Colors
 COLOR_ON = (0, 255, 68)    # Green phosphor
@@ -61,6 +85,161 @@ def decode_framebuffer(data, surface):
     del pixels
 
 
+def apply_delta(frame, payload):
+    """Apply delta row records to frame in place. False if malformed."""
+    i = 0
+    n = len(payload)
+    while i < n:
+        if i + 2 > n:
+            return False
+        y = payload[i]
+        x0 = payload[i + 1] >> 4
+        count = (payload[i + 1] & 0x0F) + 1
+        i += 2
+        if y >= FB_HEIGHT or x0 + count > 16:
+            return False
+        pos = y * 16 + x0
+        end = pos + count
+        while pos < end:
+            if i >= n:
+                return False
+            b = payload[i]
+            i += 1
+            if b:
+                frame[pos] = b
+                pos += 1
+            else:
+                if i >= n:
+                    return False
+                run = payload[i]
+                i += 1
+                if run == 0 or pos + run > end:
+                    return False
+                frame[pos:pos + run] = bytes(run)
+                pos += run
+    return True
+
+
+def load_font(path=FONT_SRC):
+    """Glyph rows from the firmware font table, {} if it can't be read."""
+    try:
+        with open(path) as f:
+            src = f.read()
+    except OSError:
+        return {}
+    font = {}
+    for m in re.finditer(r"/\* 0x([0-9A-Fa-f]{2}) .*?\*/\s*\{([^}]*)\}", src):
+        font[int(m.group(1), 16)] = [int(v, 16) for v in m.group(2).split(",")]
+    return font
+
+
+def set_pixel(frame, x, y, clip=FULL_CLIP, xor=False):
+    if clip[0] <= x <= clip[2] and clip[1] <= y <= clip[3]:
+        if xor:
+            frame[y * 16 + (x >> 3)] ^= 0x80 >> (x & 7)
+        else:
+            frame[y * 16 + (x >> 3)] |= 0x80 >> (x & 7)
+
+
+def draw_line(frame, x0, y0, x1, y1, clip=FULL_CLIP, xor=False):
+    """fb_line() from src/drivers/video.cpp, pixel for pixel (unoptimized:
+    walks the whole line, clipping each pixel)."""
+    dx, dy = x1 - x0, y1 - y0
+    sx = sy = 1
+    if dx < 0:
+        dx, sx = -dx, -1
+    if dy < 0:
+        dy, sy = -dy, -1
+    if dx >= dy:
+        err = dx >> 1
+        for _ in range(dx + 1):
+            set_pixel(frame, x0, y0, clip, xor)
+            err -= dy
+            if err < 0:
+                y0 += sy
+                err += dx
+            x0 += sx
+    else:
+        err = dy >> 1
+        for _ in range(dy + 1):
+            set_pixel(frame, x0, y0, clip, xor)
+            err -= dx
+            if err < 0:
+                x0 += sx
+                err += dy
+            y0 += sy
+
+
+def apply_list(frame, payload, font):
+    """Redraw frame from a display list. False if malformed."""
+    frame[:] = bytes(FB_SIZE)
+    i = 0
+    n = len(payload)
+    last = None
+    clip = FULL_CLIP
+    xor = False
+    try:
+        while i < n:
+            op = payload[i]
+            if op < 0x80:
+                if i + 4 > n:
+                    return False
+                x0, y0, x1, y1 = payload[i:i + 4]
+                i += 4
+            elif op == DL_LINE16:
+                if i + 9 > n:
+                    return False
+                x0, y0, x1, y1 = (int.from_bytes(payload[i + 1 + k:i + 3 + k], 'little', signed=True)
+                                  for k in (0, 2, 4, 6))
+                i += 9
+            elif op == DL_LINE_TO:
+                if last is None or i + 3 > n:
+                    return False
+                x0, y0 = last
+                x1, y1 = payload[i + 1], payload[i + 2]
+                i += 3
+            elif op == DL_PIXEL:
+                set_pixel(frame, payload[i + 1], payload[i + 2], clip, xor)
+                i += 3
+                last = None
+                continue
+            elif op == DL_CLIP:
+                if i + 5 > n:
+                    return False
+                clip = tuple(payload[i + 1:i + 5])
+                i += 5
+                last = None
+                continue
+            elif op == DL_ROP:
+                if i + 2 > n:
+                    return False
+                xor = payload[i + 1] == 1
+                i += 2
+                last = None
+                continue
+            elif op == DL_TEXT:
+                x, y, count = payload[i + 1], payload[i + 2], payload[i + 3]
+                text = payload[i + 4:i + 4 + count]
+                if len(text) != count:
+                    return False
+                for c in text:
+                    for row, bits in enumerate(font.get(c, font.get(ord('?'), []))):
+                        for col in range(FONT_W):
+                            if bits & (0x80 >> col):
+                                set_pixel(frame, x + col, y + row, clip, xor)
+                    x += FONT_W
+                i += 4 + count
+                last = None
+                continue
+            else:
+                return False
+            draw_line(frame, x0, y0, x1, y1, clip, xor)
+            last = (x1, y1) if op != DL_LINE16 else None
+    except (IndexError, ValueError):
+        return False
+    return True
+
+
 def main():
     port = sys.argv[1] if len(sys.argv) > 1 else "COM4"
     baud = int(sys.argv[2]) if len(sys.argv) > 2 else 74880
@@ -89,10 +268,23 @@ def main():
     clock = pygame.time.Clock()
     frame_count = 0
 
-    # State machine for sync detection
+    # State machine for sync detection and frame collection
     sync_state = 0       # how many sync bytes matched
+    frame = bytearray(FB_SIZE)   # what the device last sent
     frame_buf = bytearray()
-    collecting_frame = False
+    collecting = None    # None, 'key', 'len' or 'delta'
+    need = 0
+    key_frames = delta_frames = list_frames = frame_bytes = 0
+    list_frame = False
+    font = load_font()
+    if not font:
+        print(f"  warning: no font at {FONT_SRC}, list frames draw no text")
+
+    def show():
+        decode_framebuffer(frame, fb_surface)
+        scaled = pygame.transform.scale(fb_surface, (WIN_WIDTH, WIN_HEIGHT))
+        screen.blit(scaled, (0, 0))
+        pygame.display.flip()
 
     running = True
     while running:
@@ -115,27 +307,47 @@ def main():
         data = ser.read(4096)
         if data:
             for byte in data:
-                if collecting_frame:
+                if collecting:
                     frame_buf.append(byte)
-                    if len(frame_buf) >= FB_SIZE:
-                        # Full frame received
-                        decode_framebuffer(frame_buf, fb_surface)
-                        scaled = pygame.transform.scale(fb_surface, (WIN_WIDTH, WIN_HEIGHT))
-                        screen.blit(scaled, (0, 0))
-                        pygame.display.flip()
-                        frame_count += 1
-                        collecting_frame = False
-                        sync_state = 0
+                    if len(frame_buf) < need:
+                        continue
+                    if collecting == 'key':
+                        frame[:] = frame_buf
+                        key_frames += 1
+                        frame_bytes += 4 + FB_SIZE
+                        show()
+                    elif collecting == 'len':
+                        need = frame_buf[0] | (frame_buf[1] << 8)
                         frame_buf = bytearray()
+                        collecting = 'delta'
+                        if need > 0:
+                            continue
+                    if collecting == 'delta':
+                        # A bad record leaves the frame as is until the next key frame
+                        if list_frame:
+                            ok = apply_list(frame, frame_buf, font)
+                            list_frames += 1
+                        else:
+                            ok = apply_delta(frame, frame_buf)
+                            delta_frames += 1
+                        if ok:
+                            show()
+                        frame_bytes += 6 + len(frame_buf)
+                    frame_count += 1
+                    collecting = None
+                    sync_state = 0
+                    frame_buf = bytearray()
+                elif sync_state == len(SYNC) - 1 and byte in (SYNC[-1], SYNC_DELTA, SYNC_LIST):
+                    # Full sync found — start collecting frame
+                    collecting = 'key' if byte == SYNC[-1] else 'len'
+                    list_frame = byte == SYNC_LIST
+                    need = FB_SIZE if collecting == 'key' else 2
+                    frame_buf = bytearray()
                 else:
                     # Sync detection state machine
                     expected = SYNC[sync_state]
                     if byte == expected:
                         sync_state += 1
-                        if sync_state >= len(SYNC):
-                            # Full sync found — start collecting frame
-                            collecting_frame = True
-                            frame_buf = bytearray()
                     else:
                         # Output buffered sync bytes as text
                         for i in range(sync_state):
@@ -157,7 +369,9 @@ def main():
 
     pygame.quit()
     ser.close()
-    print(f"\n{frame_count} frames received")
+    print(f"\n{frame_count} frames received ({key_frames} key, {delta_frames} delta, {list_frames} list)")
+    if frame_count:
+        print(f"  {frame_bytes / frame_count:.0f} bytes/frame on the wire")
 
 
 if __name__ == '__main__':
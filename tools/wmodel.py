@@ -0,0 +1,158 @@
+#!/usr/bin/env python3
+"""
+OsitoK wireframe model converter — Wavefront OBJ to .owm.
+
+Reads vertices ('v'), polygons ('f') and polylines ('l') from an OBJ
+file and writes the binary model format loaded by src/gfx/wmodel.cpp:
+
+  header      "OWM1", nv, ne, nf, flags, radius (8.8), reserved
+  verts       nv x (x, y, z) int16 8.8
+  normals     nf x (x, y, z) int16 2.14, outward for CCW polygons
+  edges       ne x (a, b)
+  edge faces  ne x (f0, f1), 0xFF = none       (only if nf > 0)
+
+Polygon outlines become edges (shared edges once). 'l' lines add
+edges that belong to no face. Coordinates are multiplied by --scale
+and must then fit 8.8 (-128 .. 127.99); model units match the
+built-in ships, which are about +-2.
+
+Usage:
+  py tools/wmodel.py model.obj model.owm [--scale S] [--no-faces]
+  py tools/upload.py COM4 model.owm model.owm
+  osito> model load model.owm
+"""
+import argparse
+import math
+import struct
+import sys
+
+MAGIC = b"OWM1"
+MAX_VERTS = 64          # WIRE_MAX_VERTS
+MAX_EDGES = 255
+MAX_FACES = 254         # 0xFF marks "no face"
+
+
+def parse_obj(path):
+    verts, faces, lines = [], [], []
+    with open(path) as f:
+        for lineno, line in enumerate(f, 1):
+            parts = line.split()
+            if not parts or parts[0].startswith("#"):
+                continue
+            if parts[0] == "v":
+                verts.append(tuple(float(p) for p in parts[1:4]))
+            elif parts[0] in ("f", "l"):
+                idx = []
+                for p in parts[1:]:
+                    i = int(p.split("/")[0])
+                    idx.append(i - 1 if i > 0 else len(verts) + i)
+                if any(i < 0 or i >= len(verts) for i in idx):
+                    raise ValueError(f"{path}:{lineno}: vertex index out of range")
+                (faces if parts[0] == "f" else lines).append(idx)
+    return verts, faces, lines
+
+
+def newell_normal(pts):
+    """Polygon normal (Newell's method), normalized."""
+    nx = ny = nz = 0.0
+    for i, (x0, y0, z0) in enumerate(pts):
+        x1, y1, z1 = pts[(i + 1) % len(pts)]
+        nx += (y0 - y1) * (z0 + z1)
+        ny += (z0 - z1) * (x0 + x1)
+        nz += (x0 - x1) * (y0 + y1)
+    length = math.sqrt(nx * nx + ny * ny + nz * nz)
+    if length == 0:
+        return (0.0, 0.0, 0.0)
+    return (nx / length, ny / length, nz / length)
+
+
+def fix(v, frac_bits):
+    n = int(round(v * (1 << frac_bits)))
+    return max(-32768, min(32767, n))
+
+
+def build(verts, faces, lines, scale, with_faces):
+    verts = [(x * scale, y * scale, z * scale) for x, y, z in verts]
+    for v in verts:
+        if any(c < -128 or c >= 128 for c in v):
+            raise ValueError(f"vertex {v} out of 8.8 range, use a smaller --scale")
+
+    # Unique edges in first-seen order, with the faces that share them
+    edge_ids = {}
+    edges = []
+    edge_faces = []
+
+    def add_edge(a, b, face):
+        if a == b:
+            return
+        key = (min(a, b), max(a, b))
+        if key not in edge_ids:
+            edge_ids[key] = len(edges)
+            edges.append((a, b))
+            edge_faces.append([])
+        if face is not None:
+            edge_faces[edge_ids[key]].append(face)
+
+    for fi, poly in enumerate(faces):
+        for i in range(len(poly)):
+            add_edge(poly[i], poly[(i + 1) % len(poly)], fi)
+    for poly in lines:
+        for i in range(len(poly) - 1):
+            add_edge(poly[i], poly[i + 1], None)
+
+    if not with_faces:
+        faces = []
+    if len(verts) == 0 or len(verts) > MAX_VERTS:
+        raise ValueError(f"{len(verts)} vertices (1..{MAX_VERTS} allowed)")
+    if len(edges) > MAX_EDGES:
+        raise ValueError(f"{len(edges)} edges (max {MAX_EDGES})")
+    if len(faces) > MAX_FACES:
+        raise ValueError(f"{len(faces)} faces (max {MAX_FACES}), try --no-faces")
+
+    radius = max(math.sqrt(x * x + y * y + z * z) for x, y, z in verts)
+    radius88 = min(0xFFFF, int(math.ceil(radius * 256)))
+
+    out = bytearray(MAGIC)
+    out += struct.pack("<BBBBHH", len(verts), len(edges), len(faces), 0, radius88, 0)
+    for v in verts:
+        out += struct.pack("<hhh", *(fix(c, 8) for c in v))
+    for poly in faces:
+        n = newell_normal([verts[i] for i in poly])
+        out += struct.pack("<hhh", *(fix(c, 14) for c in n))
+    for a, b in edges:
+        out += bytes((a, b))
+    if faces:
+        for fl in edge_faces:
+            f0 = fl[0] if len(fl) > 0 else 0xFF
+            f1 = fl[1] if len(fl) > 1 else 0xFF
+            out += bytes((f0, f1))
+    return bytes(out), len(verts), len(edges), len(faces), radius
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Convert a Wavefront OBJ model to OsitoK .owm")
+    parser.add_argument("input", help="input .obj file")
+    parser.add_argument("output", help="output .owm file")
+    parser.add_argument("--scale", type=float, default=1.0,
+                        help="multiply coordinates by this (default 1.0)")
+    parser.add_argument("--no-faces", action="store_true",
+                        help="omit face normals and edge-face pairs")
+    args = parser.parse_args()
+
+    try:
+        verts, faces, lines = parse_obj(args.input)
+        data, nv, ne, nf, radius = build(verts, faces, lines, args.scale,
+                                         not args.no_faces)
+    except (OSError, ValueError) as e:
+        print(f"error: {e}", file=sys.stderr)
+        sys.exit(1)
+
+    with open(args.output, "wb") as f:
+        f.write(data)
+    print(f"{args.output}: {nv} verts, {ne} edges, {nf} faces, "
+          f"radius {radius:.2f}, {len(data)} bytes")
+
+
+if __name__ == "__main__":
+    main()